@@ -88,12 +88,11 @@ SEXP wrap(const AcTiterTable& t){
   int num_sr = t.nsr();
 
   CharacterMatrix titers_out(num_ags, num_sr);
-  for(int ag=0;ag<num_ags;ag++){
-    for(int sr=0;sr<num_sr;sr++){
-      std::string titer = t.get_titer_string(ag, sr);
-      titers_out(ag, sr) = titer;
+  t.get_titer_strings(
+    [&](arma::uword i, const char *titer, int length){
+      SET_STRING_ELT(titers_out, i, Rf_mkCharLen(titer, length));
     }
-  }
+  );
 
   return wrap(titers_out);
 }
@@ -250,6 +249,24 @@ SEXP wrap(const SeqInsertion& s){
   );
 }
 
+// FROM: OPTIMIZER TELEMETRY
+template <>
+SEXP wrap(const AcOptimizerTelemetry &telemetry){
+
+  return wrap(
+    List::create(
+      _["iterations"] = static_cast<int>(telemetry.iterations),
+      _["evaluations"] = static_cast<int>(telemetry.evaluations),
+      _["line_search_failures"] = static_cast<int>(telemetry.line_search_failures),
+      _["termination"] = telemetry.termination,
+      _["time"] = telemetry.time,
+      _["stage_dims"] = IntegerVector(telemetry.stage_dims.begin(), telemetry.stage_dims.end()),
+      _["stage_time"] = NumericVector(telemetry.stage_time.begin(), telemetry.stage_time.end())
+    )
+  );
+
+}
+
 // FROM: ACOPTIMIZATION
 template <>
 SEXP wrap(const AcOptimization& acopt){
@@ -269,6 +286,11 @@ SEXP wrap(const AcOptimization& acopt){
     _["bootstrap"] = acopt.bootstrap
   );
 
+  // Add telemetry if the optimization has been relaxed
+  if (!acopt.telemetry.termination.empty()) {
+    out.push_back(wrap(acopt.telemetry), "telemetry");
+  }
+
   // Set class attribute and return
   out.attr("class") = CharacterVector::create("acoptimization", "list");
   return out;
@@ -421,7 +443,8 @@ AcMergeOptions as(SEXP sxp){
     opt["sd_limit"],
     opt["dilution_stepsize"],
     opt["merge_function"],
-    opt["method"]
+    opt["method"],
+    opt.containsElementNamed("num_cores") ? as<int>(opt["num_cores"]) : 1
   };
 
 }
@@ -433,6 +456,10 @@ AcOptimizerOptions as(SEXP sxp){
   List opt = as<List>(sxp);
   return AcOptimizerOptions{
     opt["dim_annealing"],
+    as<arma::uvec>(opt["annealing_dims"]),
+    as<arma::ivec>(opt["annealing_maxit"]),
+    as<arma::vec>(opt["annealing_factr"]),
+    as<arma::vec>(opt["annealing_min_gradient_norm"]),
     opt["method"],
     opt["maxit"],
     opt["num_basis"],
@@ -444,6 +471,19 @@ AcOptimizerOptions as(SEXP sxp){
     opt["min_step"],
     opt["max_step"],
     opt["num_cores"],
+    opt["num_eval_cores"],
+    opt["racing"],
+    opt["racing_interval"],
+    opt["racing_num_best"],
+    opt["racing_tolerance"],
+    opt["keep_best"],
+    opt["start_method"],
+    opt["start_mds_noise"],
+    opt["convergence_num_runs"],
+    opt["convergence_tolerance"],
+    opt["convergence_procrustes_tolerance"],
+    opt["time_budget"],
+    opt["checkpoint_file"],
     opt["report_progress"],
     opt["progress_bar_length"]
   };
@@ -470,14 +510,9 @@ AcTiterTable as(SEXP sxp){
     num_sr
   );
 
-  for(int ag=0; ag<num_ags; ag++){
-    for(int sr=0; sr<num_sr; sr++){
-      titertable.set_titer_string(
-        ag, sr,
-        as<std::string>(titers(ag,sr))
-      );
-    }
-  }
+  titertable.set_titer_strings(
+    [&](arma::uword i){ return CHAR(STRING_ELT(titers, i)); }
+  );
 
   return titertable;
 
@@ -613,6 +648,27 @@ BootstrapOutput as(SEXP sxp) {
 
 }
 
+// TO: OPTIMIZER TELEMETRY
+template <>
+AcOptimizerTelemetry as(SEXP sxp) {
+
+  List list = as<List>(sxp);
+  AcOptimizerTelemetry out;
+
+  out.iterations = as<int>(list["iterations"]);
+  out.evaluations = as<int>(list["evaluations"]);
+  out.line_search_failures = as<int>(list["line_search_failures"]);
+  out.termination = as<std::string>(list["termination"]);
+  out.time = as<double>(list["time"]);
+  if (list.containsElementNamed("stage_dims")) {
+    out.stage_dims = as<arma::uvec>(list["stage_dims"]);
+    out.stage_time = as<arma::vec>(list["stage_time"]);
+  }
+
+  return out;
+
+}
+
 // TO: ACDIAGNOSTICS
 template <>
 AcDiagnostics as(SEXP sxp){
@@ -705,6 +761,9 @@ AcOptimization as(SEXP sxp){
   if(opt.containsElementNamed("bootstrap")) {
     acopt.bootstrap = as<std::vector<BootstrapOutput>>(wrap(opt["bootstrap"]));
   }
+  if(opt.containsElementNamed("telemetry")) {
+    acopt.telemetry = as<AcOptimizerTelemetry>(wrap(opt["telemetry"]));
+  }
   if(opt.containsElementNamed("stress")) {
     acopt.set_stress( as<double>(wrap(opt["stress"])) );
   }
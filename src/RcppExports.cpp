@@ -1299,9 +1299,38 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// ac_benchmark_stress_gradient
+Rcpp::List ac_benchmark_stress_gradient(const AcTiterTable& titers, const arma::mat& ag_coords, const arma::mat& sr_coords, const int& num_evaluations, const int& num_eval_cores);
+RcppExport SEXP _Racmacs_ac_benchmark_stress_gradient(SEXP titersSEXP, SEXP ag_coordsSEXP, SEXP sr_coordsSEXP, SEXP num_evaluationsSEXP, SEXP num_eval_coresSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const AcTiterTable& >::type titers(titersSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type ag_coords(ag_coordsSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type sr_coords(sr_coordsSEXP);
+    Rcpp::traits::input_parameter< const int& >::type num_evaluations(num_evaluationsSEXP);
+    Rcpp::traits::input_parameter< const int& >::type num_eval_cores(num_eval_coresSEXP);
+    rcpp_result_gen = Rcpp::wrap(ac_benchmark_stress_gradient(titers, ag_coords, sr_coords, num_evaluations, num_eval_cores));
+    return rcpp_result_gen;
+END_RCPP
+}
+// ac_benchmark_relaxation
+Rcpp::List ac_benchmark_relaxation(const AcTiterTable& titers, const arma::mat& ag_coords, const arma::mat& sr_coords, const AcOptimizerOptions& options);
+RcppExport SEXP _Racmacs_ac_benchmark_relaxation(SEXP titersSEXP, SEXP ag_coordsSEXP, SEXP sr_coordsSEXP, SEXP optionsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const AcTiterTable& >::type titers(titersSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type ag_coords(ag_coordsSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type sr_coords(sr_coordsSEXP);
+    Rcpp::traits::input_parameter< const AcOptimizerOptions& >::type options(optionsSEXP);
+    rcpp_result_gen = Rcpp::wrap(ac_benchmark_relaxation(titers, ag_coords, sr_coords, options));
+    return rcpp_result_gen;
+END_RCPP
+}
 // ac_bootstrap_map
-BootstrapOutput ac_bootstrap_map(const AcMap map, std::string method, bool bootstrap_ags, bool bootstrap_sr, bool reoptimize, double ag_noise_sd, double titer_noise_sd, std::string minimum_column_basis, arma::vec fixed_column_bases, arma::vec ag_reactivity_adjustments, int num_optimizations, int num_dimensions, AcOptimizerOptions options);
-RcppExport SEXP _Racmacs_ac_bootstrap_map(SEXP mapSEXP, SEXP methodSEXP, SEXP bootstrap_agsSEXP, SEXP bootstrap_srSEXP, SEXP reoptimizeSEXP, SEXP ag_noise_sdSEXP, SEXP titer_noise_sdSEXP, SEXP minimum_column_basisSEXP, SEXP fixed_column_basesSEXP, SEXP ag_reactivity_adjustmentsSEXP, SEXP num_optimizationsSEXP, SEXP num_dimensionsSEXP, SEXP optionsSEXP) {
+BootstrapOutput ac_bootstrap_map(const AcMap map, std::string method, bool bootstrap_ags, bool bootstrap_sr, bool reoptimize, double ag_noise_sd, double titer_noise_sd, std::string minimum_column_basis, arma::vec fixed_column_bases, arma::vec ag_reactivity_adjustments, int num_optimizations, int num_dimensions, AcOptimizerOptions options, double seed, int repeat_number);
+RcppExport SEXP _Racmacs_ac_bootstrap_map(SEXP mapSEXP, SEXP methodSEXP, SEXP bootstrap_agsSEXP, SEXP bootstrap_srSEXP, SEXP reoptimizeSEXP, SEXP ag_noise_sdSEXP, SEXP titer_noise_sdSEXP, SEXP minimum_column_basisSEXP, SEXP fixed_column_basesSEXP, SEXP ag_reactivity_adjustmentsSEXP, SEXP num_optimizationsSEXP, SEXP num_dimensionsSEXP, SEXP optionsSEXP, SEXP seedSEXP, SEXP repeat_numberSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -1318,7 +1347,9 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< int >::type num_optimizations(num_optimizationsSEXP);
     Rcpp::traits::input_parameter< int >::type num_dimensions(num_dimensionsSEXP);
     Rcpp::traits::input_parameter< AcOptimizerOptions >::type options(optionsSEXP);
-    rcpp_result_gen = Rcpp::wrap(ac_bootstrap_map(map, method, bootstrap_ags, bootstrap_sr, reoptimize, ag_noise_sd, titer_noise_sd, minimum_column_basis, fixed_column_bases, ag_reactivity_adjustments, num_optimizations, num_dimensions, options));
+    Rcpp::traits::input_parameter< double >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< int >::type repeat_number(repeat_numberSEXP);
+    rcpp_result_gen = Rcpp::wrap(ac_bootstrap_map(map, method, bootstrap_ags, bootstrap_sr, reoptimize, ag_noise_sd, titer_noise_sd, minimum_column_basis, fixed_column_bases, ag_reactivity_adjustments, num_optimizations, num_dimensions, options, seed, repeat_number));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -1415,6 +1446,18 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// ac_titer_layer_merge_all
+Rcpp::List ac_titer_layer_merge_all(const std::vector<AcTiterTable>& titer_layers, const AcMergeOptions& options);
+RcppExport SEXP _Racmacs_ac_titer_layer_merge_all(SEXP titer_layersSEXP, SEXP optionsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::vector<AcTiterTable>& >::type titer_layers(titer_layersSEXP);
+    Rcpp::traits::input_parameter< const AcMergeOptions& >::type options(optionsSEXP);
+    rcpp_result_gen = Rcpp::wrap(ac_titer_layer_merge_all(titer_layers, options));
+    return rcpp_result_gen;
+END_RCPP
+}
 // ac_merge_tables
 AcMap ac_merge_tables(std::vector<AcMap> maps, const AcMergeOptions& merge_options);
 RcppExport SEXP _Racmacs_ac_merge_tables(SEXP mapsSEXP, SEXP merge_optionsSEXP) {
@@ -1509,25 +1552,27 @@ BEGIN_RCPP
 END_RCPP
 }
 // ac_titer_layer_merge_types
-arma::imat ac_titer_layer_merge_types(const std::vector<AcTiterTable>& titer_layers);
-RcppExport SEXP _Racmacs_ac_titer_layer_merge_types(SEXP titer_layersSEXP) {
+arma::imat ac_titer_layer_merge_types(const std::vector<AcTiterTable>& titer_layers, const int num_cores);
+RcppExport SEXP _Racmacs_ac_titer_layer_merge_types(SEXP titer_layersSEXP, SEXP num_coresSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< const std::vector<AcTiterTable>& >::type titer_layers(titer_layersSEXP);
-    rcpp_result_gen = Rcpp::wrap(ac_titer_layer_merge_types(titer_layers));
+    Rcpp::traits::input_parameter< const int >::type num_cores(num_coresSEXP);
+    rcpp_result_gen = Rcpp::wrap(ac_titer_layer_merge_types(titer_layers, num_cores));
     return rcpp_result_gen;
 END_RCPP
 }
 // ac_titer_layer_sd
-arma::mat ac_titer_layer_sd(const std::vector<AcTiterTable>& titer_layers, const double dilution_stepsize);
-RcppExport SEXP _Racmacs_ac_titer_layer_sd(SEXP titer_layersSEXP, SEXP dilution_stepsizeSEXP) {
+arma::mat ac_titer_layer_sd(const std::vector<AcTiterTable>& titer_layers, const double dilution_stepsize, const int num_cores);
+RcppExport SEXP _Racmacs_ac_titer_layer_sd(SEXP titer_layersSEXP, SEXP dilution_stepsizeSEXP, SEXP num_coresSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< const std::vector<AcTiterTable>& >::type titer_layers(titer_layersSEXP);
     Rcpp::traits::input_parameter< const double >::type dilution_stepsize(dilution_stepsizeSEXP);
-    rcpp_result_gen = Rcpp::wrap(ac_titer_layer_sd(titer_layers, dilution_stepsize));
+    Rcpp::traits::input_parameter< const int >::type num_cores(num_coresSEXP);
+    rcpp_result_gen = Rcpp::wrap(ac_titer_layer_sd(titer_layers, dilution_stepsize, num_cores));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -1630,9 +1675,48 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// ac_runOptimizationShard
+std::vector<AcOptimization> ac_runOptimizationShard(const AcTiterTable& titertable, const std::string& minimum_col_basis, const arma::vec& fixed_colbases, const arma::vec& ag_reactivity_adjustments, const arma::uword& num_dims, const arma::uword& first_run, const arma::uword& num_optimizations, const AcOptimizerOptions& options, const arma::mat& titer_weights, const double& dilution_stepsize, const double& seed);
+RcppExport SEXP _Racmacs_ac_runOptimizationShard(SEXP titertableSEXP, SEXP minimum_col_basisSEXP, SEXP fixed_colbasesSEXP, SEXP ag_reactivity_adjustmentsSEXP, SEXP num_dimsSEXP, SEXP first_runSEXP, SEXP num_optimizationsSEXP, SEXP optionsSEXP, SEXP titer_weightsSEXP, SEXP dilution_stepsizeSEXP, SEXP seedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const AcTiterTable& >::type titertable(titertableSEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type minimum_col_basis(minimum_col_basisSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type fixed_colbases(fixed_colbasesSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type ag_reactivity_adjustments(ag_reactivity_adjustmentsSEXP);
+    Rcpp::traits::input_parameter< const arma::uword& >::type num_dims(num_dimsSEXP);
+    Rcpp::traits::input_parameter< const arma::uword& >::type first_run(first_runSEXP);
+    Rcpp::traits::input_parameter< const arma::uword& >::type num_optimizations(num_optimizationsSEXP);
+    Rcpp::traits::input_parameter< const AcOptimizerOptions& >::type options(optionsSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type titer_weights(titer_weightsSEXP);
+    Rcpp::traits::input_parameter< const double& >::type dilution_stepsize(dilution_stepsizeSEXP);
+    Rcpp::traits::input_parameter< const double& >::type seed(seedSEXP);
+    rcpp_result_gen = Rcpp::wrap(ac_runOptimizationShard(titertable, minimum_col_basis, fixed_colbases, ag_reactivity_adjustments, num_dims, first_run, num_optimizations, options, titer_weights, dilution_stepsize, seed));
+    return rcpp_result_gen;
+END_RCPP
+}
+// ac_tableStartBoxsize
+double ac_tableStartBoxsize(const AcTiterTable& titertable, const std::string& minimum_col_basis, const arma::vec& fixed_colbases, const arma::vec& ag_reactivity_adjustments, const arma::uword& num_dims, const AcOptimizerOptions& options, const arma::mat& titer_weights, const double& dilution_stepsize);
+RcppExport SEXP _Racmacs_ac_tableStartBoxsize(SEXP titertableSEXP, SEXP minimum_col_basisSEXP, SEXP fixed_colbasesSEXP, SEXP ag_reactivity_adjustmentsSEXP, SEXP num_dimsSEXP, SEXP optionsSEXP, SEXP titer_weightsSEXP, SEXP dilution_stepsizeSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const AcTiterTable& >::type titertable(titertableSEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type minimum_col_basis(minimum_col_basisSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type fixed_colbases(fixed_colbasesSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type ag_reactivity_adjustments(ag_reactivity_adjustmentsSEXP);
+    Rcpp::traits::input_parameter< const arma::uword& >::type num_dims(num_dimsSEXP);
+    Rcpp::traits::input_parameter< const AcOptimizerOptions& >::type options(optionsSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type titer_weights(titer_weightsSEXP);
+    Rcpp::traits::input_parameter< const double& >::type dilution_stepsize(dilution_stepsizeSEXP);
+    rcpp_result_gen = Rcpp::wrap(ac_tableStartBoxsize(titertable, minimum_col_basis, fixed_colbases, ag_reactivity_adjustments, num_dims, options, titer_weights, dilution_stepsize));
+    return rcpp_result_gen;
+END_RCPP
+}
 // ac_reactivity_adjustment_stress
-double ac_reactivity_adjustment_stress(const arma::vec& par, const arma::vec& fixed_ag_reactivities, const std::string& minimum_column_basis, const arma::vec& fixed_column_bases, const AcTiterTable& titertable, arma::mat ag_coords, arma::mat sr_coords, AcOptimizerOptions& options, const arma::uvec& fixed_antigens, const arma::uvec& fixed_sera, const arma::mat& titer_weights, const double& reactivity_stress_weighting, const bool reoptimize, const arma::uword num_optimizations, const double& dilution_stepsize);
-RcppExport SEXP _Racmacs_ac_reactivity_adjustment_stress(SEXP parSEXP, SEXP fixed_ag_reactivitiesSEXP, SEXP minimum_column_basisSEXP, SEXP fixed_column_basesSEXP, SEXP titertableSEXP, SEXP ag_coordsSEXP, SEXP sr_coordsSEXP, SEXP optionsSEXP, SEXP fixed_antigensSEXP, SEXP fixed_seraSEXP, SEXP titer_weightsSEXP, SEXP reactivity_stress_weightingSEXP, SEXP reoptimizeSEXP, SEXP num_optimizationsSEXP, SEXP dilution_stepsizeSEXP) {
+double ac_reactivity_adjustment_stress(const arma::vec& par, const arma::vec& fixed_ag_reactivities, const std::string& minimum_column_basis, const arma::vec& fixed_column_bases, const AcTiterTable& titertable, arma::mat ag_coords, arma::mat sr_coords, AcOptimizerOptions& options, const arma::uvec& fixed_antigens, const arma::uvec& fixed_sera, const arma::mat& titer_weights, const double& reactivity_stress_weighting, const bool reoptimize, const arma::uword num_optimizations, const double& dilution_stepsize, const double& start_boxsize);
+RcppExport SEXP _Racmacs_ac_reactivity_adjustment_stress(SEXP parSEXP, SEXP fixed_ag_reactivitiesSEXP, SEXP minimum_column_basisSEXP, SEXP fixed_column_basesSEXP, SEXP titertableSEXP, SEXP ag_coordsSEXP, SEXP sr_coordsSEXP, SEXP optionsSEXP, SEXP fixed_antigensSEXP, SEXP fixed_seraSEXP, SEXP titer_weightsSEXP, SEXP reactivity_stress_weightingSEXP, SEXP reoptimizeSEXP, SEXP num_optimizationsSEXP, SEXP dilution_stepsizeSEXP, SEXP start_boxsizeSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -1651,7 +1735,24 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< const bool >::type reoptimize(reoptimizeSEXP);
     Rcpp::traits::input_parameter< const arma::uword >::type num_optimizations(num_optimizationsSEXP);
     Rcpp::traits::input_parameter< const double& >::type dilution_stepsize(dilution_stepsizeSEXP);
-    rcpp_result_gen = Rcpp::wrap(ac_reactivity_adjustment_stress(par, fixed_ag_reactivities, minimum_column_basis, fixed_column_bases, titertable, ag_coords, sr_coords, options, fixed_antigens, fixed_sera, titer_weights, reactivity_stress_weighting, reoptimize, num_optimizations, dilution_stepsize));
+    Rcpp::traits::input_parameter< const double& >::type start_boxsize(start_boxsizeSEXP);
+    rcpp_result_gen = Rcpp::wrap(ac_reactivity_adjustment_stress(par, fixed_ag_reactivities, minimum_column_basis, fixed_column_bases, titertable, ag_coords, sr_coords, options, fixed_antigens, fixed_sera, titer_weights, reactivity_stress_weighting, reoptimize, num_optimizations, dilution_stepsize, start_boxsize));
+    return rcpp_result_gen;
+END_RCPP
+}
+// ac_relax_ag_point
+arma::rowvec ac_relax_ag_point(arma::rowvec coords, const arma::mat& sr_coords, const arma::vec& table_dists, const arma::ivec& titer_types, const AcOptimizerOptions& options, const double& dilution_stepsize);
+RcppExport SEXP _Racmacs_ac_relax_ag_point(SEXP coordsSEXP, SEXP sr_coordsSEXP, SEXP table_distsSEXP, SEXP titer_typesSEXP, SEXP optionsSEXP, SEXP dilution_stepsizeSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< arma::rowvec >::type coords(coordsSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type sr_coords(sr_coordsSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type table_dists(table_distsSEXP);
+    Rcpp::traits::input_parameter< const arma::ivec& >::type titer_types(titer_typesSEXP);
+    Rcpp::traits::input_parameter< const AcOptimizerOptions& >::type options(optionsSEXP);
+    Rcpp::traits::input_parameter< const double& >::type dilution_stepsize(dilution_stepsizeSEXP);
+    rcpp_result_gen = Rcpp::wrap(ac_relax_ag_point(coords, sr_coords, table_dists, titer_types, options, dilution_stepsize));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -2004,7 +2105,9 @@ static const R_CallMethodDef CallEntries[] = {
     {"_Racmacs_ac_sr_set_homologous_ags", (DL_FUNC) &_Racmacs_ac_sr_set_homologous_ags, 2},
     {"_Racmacs_ac_sr_set_group", (DL_FUNC) &_Racmacs_ac_sr_set_group, 2},
     {"_Racmacs_ac_sr_set_group_levels", (DL_FUNC) &_Racmacs_ac_sr_set_group_levels, 2},
-    {"_Racmacs_ac_bootstrap_map", (DL_FUNC) &_Racmacs_ac_bootstrap_map, 13},
+    {"_Racmacs_ac_benchmark_stress_gradient", (DL_FUNC) &_Racmacs_ac_benchmark_stress_gradient, 5},
+    {"_Racmacs_ac_benchmark_relaxation", (DL_FUNC) &_Racmacs_ac_benchmark_relaxation, 4},
+    {"_Racmacs_ac_bootstrap_map", (DL_FUNC) &_Racmacs_ac_bootstrap_map, 15},
     {"_Racmacs_ac_dimension_test_map", (DL_FUNC) &_Racmacs_ac_dimension_test_map, 8},
     {"_Racmacs_ac_errorline_data", (DL_FUNC) &_Racmacs_ac_errorline_data, 1},
     {"_Racmacs_ac_hemi_test", (DL_FUNC) &_Racmacs_ac_hemi_test, 6},
@@ -2012,6 +2115,7 @@ static const R_CallMethodDef CallEntries[] = {
     {"_Racmacs_ac_match_map_sr", (DL_FUNC) &_Racmacs_ac_match_map_sr, 2},
     {"_Racmacs_ac_merge_titers", (DL_FUNC) &_Racmacs_ac_merge_titers, 2},
     {"_Racmacs_ac_merge_titer_layers", (DL_FUNC) &_Racmacs_ac_merge_titer_layers, 2},
+    {"_Racmacs_ac_titer_layer_merge_all", (DL_FUNC) &_Racmacs_ac_titer_layer_merge_all, 2},
     {"_Racmacs_ac_merge_tables", (DL_FUNC) &_Racmacs_ac_merge_tables, 2},
     {"_Racmacs_ac_merge_reoptimized", (DL_FUNC) &_Racmacs_ac_merge_reoptimized, 6},
     {"_Racmacs_ac_merge_frozen_overlay", (DL_FUNC) &_Racmacs_ac_merge_frozen_overlay, 2},
@@ -2019,15 +2123,18 @@ static const R_CallMethodDef CallEntries[] = {
     {"_Racmacs_ac_merge_frozen_merge", (DL_FUNC) &_Racmacs_ac_merge_frozen_merge, 3},
     {"_Racmacs_ac_merge_incremental", (DL_FUNC) &_Racmacs_ac_merge_incremental, 6},
     {"_Racmacs_ac_titer_merge_type", (DL_FUNC) &_Racmacs_ac_titer_merge_type, 1},
-    {"_Racmacs_ac_titer_layer_merge_types", (DL_FUNC) &_Racmacs_ac_titer_layer_merge_types, 1},
-    {"_Racmacs_ac_titer_layer_sd", (DL_FUNC) &_Racmacs_ac_titer_layer_sd, 2},
+    {"_Racmacs_ac_titer_layer_merge_types", (DL_FUNC) &_Racmacs_ac_titer_layer_merge_types, 2},
+    {"_Racmacs_ac_titer_layer_sd", (DL_FUNC) &_Racmacs_ac_titer_layer_sd, 3},
     {"_Racmacs_ac_move_trapped_points", (DL_FUNC) &_Racmacs_ac_move_trapped_points, 6},
     {"_Racmacs_ac_coords_stress", (DL_FUNC) &_Racmacs_ac_coords_stress, 7},
     {"_Racmacs_ac_point_stresses", (DL_FUNC) &_Racmacs_ac_point_stresses, 6},
     {"_Racmacs_ac_point_residuals", (DL_FUNC) &_Racmacs_ac_point_residuals, 2},
     {"_Racmacs_ac_relax_coords", (DL_FUNC) &_Racmacs_ac_relax_coords, 9},
     {"_Racmacs_ac_runOptimizations", (DL_FUNC) &_Racmacs_ac_runOptimizations, 9},
-    {"_Racmacs_ac_reactivity_adjustment_stress", (DL_FUNC) &_Racmacs_ac_reactivity_adjustment_stress, 15},
+    {"_Racmacs_ac_runOptimizationShard", (DL_FUNC) &_Racmacs_ac_runOptimizationShard, 11},
+    {"_Racmacs_ac_tableStartBoxsize", (DL_FUNC) &_Racmacs_ac_tableStartBoxsize, 8},
+    {"_Racmacs_ac_reactivity_adjustment_stress", (DL_FUNC) &_Racmacs_ac_reactivity_adjustment_stress, 16},
+    {"_Racmacs_ac_relax_ag_point", (DL_FUNC) &_Racmacs_ac_relax_ag_point, 6},
     {"_Racmacs_ac_stress_blob_grid", (DL_FUNC) &_Racmacs_ac_stress_blob_grid, 7},
     {"_Racmacs_numeric_titers", (DL_FUNC) &_Racmacs_numeric_titers, 1},
     {"_Racmacs_log_titers", (DL_FUNC) &_Racmacs_log_titers, 2},
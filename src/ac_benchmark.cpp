@@ -0,0 +1,130 @@
+
+#include <RcppArmadillo.h>
+#include <chrono>
+#include "acmap_titers.h"
+#include "acmap_optimization.h"
+#include "ac_stress_problem.h"
+#include "ac_map_optimizer.h"
+#include "ac_optimizer_options.h"
+
+// Functions for timing the optimization engine on synthetic data, these are
+// called from the benchmarking functions in R/map_optimize_benchmark.R
+
+// Setup the stress problem for a titer table with default column bases
+AcStressProblem benchmark_stress_problem(
+    const AcTiterTable &titers
+){
+
+  arma::vec fixed_colbases(titers.nsr());
+  fixed_colbases.fill(arma::datum::nan);
+  arma::vec ag_reactivity_adjustments(titers.nags(), arma::fill::zeros);
+
+  return AcStressProblem(
+    titers.numeric_table_distances(
+      "none",
+      fixed_colbases,
+      ag_reactivity_adjustments
+    ),
+    titers.get_titer_types()
+  );
+
+}
+
+// Time repeated evaluations of the stress and gradient
+template <arma::uword DIMS>
+double time_stress_gradient(
+    const AcStressProblem &problem,
+    const arma::mat &ag_coords,
+    const arma::mat &sr_coords,
+    const int &num_evaluations,
+    const int &num_eval_cores
+){
+
+  MapOptimizer<DIMS> map(
+    problem,
+    ag_coords,
+    sr_coords
+  );
+  map.set_num_threads(num_eval_cores);
+
+  arma::mat pars = arma::join_cols(ag_coords, sr_coords);
+  arma::mat grad;
+
+  // Do one evaluation first so buffers are allocated before timing
+  map.EvaluateWithGradient(pars, grad);
+
+  auto start_time = std::chrono::steady_clock::now();
+  for (int i=0; i<num_evaluations; i++) {
+    map.EvaluateWithGradient(pars, grad);
+  }
+  std::chrono::duration<double> run_time = std::chrono::steady_clock::now() - start_time;
+  return run_time.count();
+
+}
+
+// [[Rcpp::export]]
+Rcpp::List ac_benchmark_stress_gradient(
+    const AcTiterTable &titers,
+    const arma::mat &ag_coords,
+    const arma::mat &sr_coords,
+    const int &num_evaluations,
+    const int &num_eval_cores
+){
+
+  AcStressProblem problem = benchmark_stress_problem(titers);
+
+  double time;
+  switch(ag_coords.n_cols) {
+  case 2:
+    time = time_stress_gradient<2>(problem, ag_coords, sr_coords, num_evaluations, num_eval_cores);
+    break;
+  case 3:
+    time = time_stress_gradient<3>(problem, ag_coords, sr_coords, num_evaluations, num_eval_cores);
+    break;
+  default:
+    time = time_stress_gradient<0>(problem, ag_coords, sr_coords, num_evaluations, num_eval_cores);
+  }
+
+  return Rcpp::List::create(
+    Rcpp::_["evaluations"] = num_evaluations,
+    Rcpp::_["time"] = time,
+    Rcpp::_["evaluations_per_second"] = num_evaluations / time
+  );
+
+}
+
+// [[Rcpp::export]]
+Rcpp::List ac_benchmark_relaxation(
+    const AcTiterTable &titers,
+    const arma::mat &ag_coords,
+    const arma::mat &sr_coords,
+    const AcOptimizerOptions &options
+){
+
+  // Time the whole relaxation, including setting up the stress problem
+  auto start_time = std::chrono::steady_clock::now();
+
+  AcOptimization optimization(
+    ag_coords.n_cols,
+    ag_coords.n_rows,
+    sr_coords.n_rows
+  );
+  optimization.set_ag_base_coords(ag_coords);
+  optimization.set_sr_base_coords(sr_coords);
+  optimization.relax_from_stress_problem(
+    benchmark_stress_problem(titers),
+    options
+  );
+
+  std::chrono::duration<double> run_time = std::chrono::steady_clock::now() - start_time;
+  double time = run_time.count();
+
+  return Rcpp::List::create(
+    Rcpp::_["iterations"] = static_cast<int>(optimization.telemetry.iterations),
+    Rcpp::_["evaluations"] = static_cast<int>(optimization.telemetry.evaluations),
+    Rcpp::_["time"] = time,
+    Rcpp::_["evaluations_per_second"] = optimization.telemetry.evaluations / time,
+    Rcpp::_["stress"] = optimization.stress
+  );
+
+}
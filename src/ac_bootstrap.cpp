@@ -4,13 +4,16 @@
 #include "ac_optim_map_stress.h"
 #include "ac_bootstrap.h"
 #include "ac_optimizer_options.h"
+#include "ac_rng.h"
 
 // Function for sampling from a dirichilet
 arma::vec rdirichilet(
-    arma::uword n
+    arma::uword n,
+    AcRng &rng
 ) {
 
-  arma::vec beta_sample = arma::randg<arma::vec>( n );
+  arma::vec beta_sample(n);
+  for (arma::uword i=0; i<n; i++) beta_sample(i) = rng.randg();
   return beta_sample / arma::accu(beta_sample);
 
 }
@@ -29,9 +32,17 @@ BootstrapOutput ac_bootstrap_map(
     arma::vec ag_reactivity_adjustments,
     int num_optimizations,
     int num_dimensions,
-    AcOptimizerOptions options
+    AcOptimizerOptions options,
+    double seed,
+    int repeat_number
 ){
 
+  // Random numbers for each bootstrap repeat come from their own stream
+  AcRng rng(static_cast<uint64_t>(seed), repeat_number);
+
+  // Runs on each resampled table are not checkpointed
+  options.checkpoint_file = "";
+
   // Fetch titer table
   AcTiterTable titer_table = map.titer_table_flat;
   arma::uword num_ags = titer_table.nags();
@@ -45,13 +56,13 @@ BootstrapOutput ac_bootstrap_map(
   if (method == "noisy") {
 
     // First a matrix of shared antigen noise
-    arma::vec ag_noise = arma::randn<arma::vec>(num_ags)*ag_noise_sd;
+    arma::vec ag_noise = rng.randn<arma::vec>(num_ags)*ag_noise_sd;
     arma::mat ag_noise_matrix(num_ags, num_sr, arma::fill::zeros);
     ag_noise_matrix.each_col() += ag_noise;
     titer_table.add_log_titers(ag_noise_matrix);
 
     // Then a full matrix of titer noise
-    arma::mat titer_noise = arma::randn<arma::mat>(num_ags, num_sr)*titer_noise_sd;
+    arma::mat titer_noise = rng.randn<arma::mat>(num_ags, num_sr)*titer_noise_sd;
     titer_table.add_log_titers(titer_noise);
 
     // Save ag weights into point weights
@@ -76,14 +87,12 @@ BootstrapOutput ac_bootstrap_map(
 
     if (bootstrap_ags) {
       ag_weights.zeros();
-      arma::uvec ag_sample = arma::randi<arma::uvec>(num_ags, arma::distr_param(0, num_ags - 1));
-      for (arma::uword i=0; i<num_ags; i++) ag_weights(ag_sample(i)) += 1.0;
+      for (arma::uword i=0; i<num_ags; i++) ag_weights(rng.randi(num_ags)) += 1.0;
     }
 
     if (bootstrap_sr) {
       sr_weights.zeros();
-      arma::uvec sr_sample = arma::randi<arma::uvec>(num_sr, arma::distr_param(0, num_sr - 1));
-      for (arma::uword i=0; i<num_sr; i++) sr_weights(sr_sample(i)) += 1.0;
+      for (arma::uword i=0; i<num_sr; i++) sr_weights(rng.randi(num_sr)) += 1.0;
     }
 
     // Save into point weights
@@ -94,8 +103,8 @@ BootstrapOutput ac_bootstrap_map(
   // Set weights according to a dirichilet distribution
   if (method == "bayesian") {
 
-    if (bootstrap_ags) ag_weights = rdirichilet(num_ags);
-    if (bootstrap_sr) sr_weights = rdirichilet(num_sr);
+    if (bootstrap_ags) ag_weights = rdirichilet(num_ags, rng);
+    if (bootstrap_sr) sr_weights = rdirichilet(num_sr, rng);
 
     // Save into point weights
     pt_sampling = arma::join_cols(ag_weights, sr_weights);
@@ -124,7 +133,8 @@ BootstrapOutput ac_bootstrap_map(
       num_optimizations,
       options,
       titer_weights,
-      map.dilution_stepsize
+      map.dilution_stepsize,
+      rng.next()
     );
 
     // Sort by stress and keep lowest stress coords
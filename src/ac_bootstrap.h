@@ -21,7 +21,9 @@ BootstrapOutput ac_bootstrap_map(
     arma::vec ag_reactivity_adjustments,
     int num_optimizations,
     int num_dimensions,
-    AcOptimizerOptions options
+    AcOptimizerOptions options,
+    double seed,
+    int repeat_number
 );
 
 #endif
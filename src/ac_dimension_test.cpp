@@ -17,8 +17,10 @@ DimTestOutput ac_dimension_test_map(
   AcOptimizerOptions options
 ) {
 
-  // Silence normal optimization progress reporting
+  // Silence normal optimization progress reporting, and do not checkpoint
+  // runs on each of the test tables
   options.report_progress = false;
+  options.checkpoint_file = "";
 
   // Get a random index of measured titers to test
   int num_measured = titer_table.num_measured();
@@ -3,6 +3,7 @@
 #include "ac_hemi_test.h"
 #include "ac_stress_blobs.h"
 #include "acmap_optimization.h"
+#include "ac_point_optimizer.h"
 #include "utils.h"
 #include "utils_error.h"
 
@@ -19,7 +20,6 @@ std::vector<HemiData> ac_hemi_test_points(
 
   // Set variables
   arma::uword num_ags = ag_coords.n_rows;
-  arma::uword num_sr = sr_coords.n_rows;
   arma::uword dim = ag_coords.n_cols;
 
   // Check input
@@ -34,8 +34,6 @@ std::vector<HemiData> ac_hemi_test_points(
   arma::rowvec hemi_ag_orig_coords( dim );
   arma::rowvec hemi_ag_improved_coords( dim );
   arma::rowvec hemi_ag_relaxed_coords( dim );
-  arma::uvec fixed_antigens;
-  arma::uvec fixed_sera;
 
   // Check hemisphering antigens
   for(arma::uword ag=0; ag<num_ags; ag++){
@@ -48,8 +46,8 @@ std::vector<HemiData> ac_hemi_test_points(
     StressBlobGrid grid_results = ac_stress_blob_grid(
       ag_coords.row(ag).as_col(),
       sr_coords,
-      tabledists.row(ag).as_col(),
-      titertypes.row(ag).as_col(),
+      tabledists.row(ag).t(),
+      titertypes.row(ag).t(),
       stress_lim,
       grid_spacing
     );
@@ -57,6 +55,16 @@ std::vector<HemiData> ac_hemi_test_points(
     // Get indices of those with lower stress
     arma::uvec indices = arma::find( grid_results.grid < stress_lim );
 
+    // Setup relaxation of the antigen alone, against the sera it has titers
+    // with, since all other points stay fixed
+    AcPointOptimizer point(
+      sr_coords,
+      tabledists.row(ag).t(),
+      titertypes.row(ag).t(),
+      arma::vec(),
+      dilution_stepsize
+    );
+
     // For those with lower stress see if they move back to the original position
     // on relaxing the map
     for(arma::uword i=0; i<indices.n_elem; i++){
@@ -72,30 +80,14 @@ std::vector<HemiData> ac_hemi_test_points(
         hemi_ag_improved_coords(2) = grid_results.zcoords( sub(2) );
       }
 
-      // Move the antigen to the test position
-      ag_coords.row(ag) = hemi_ag_improved_coords;
-
-      // Set other points to be fixed
-      fixed_antigens = arma::regspace<arma::uvec>( 0, num_ags - 1);
-      fixed_sera = arma::regspace<arma::uvec>( 0, num_sr - 1);
-      fixed_antigens.shed_row( ag );
-
-      // Relax the coordinates
-      ac_relax_coords(
-        tabledists,
-        titertypes,
-        ag_coords,
-        sr_coords,
-        options,
-        fixed_antigens,
-        fixed_sera
+      // Relax the antigen from the test position
+      hemi_ag_relaxed_coords = hemi_ag_improved_coords;
+      ac_relax_point(
+        hemi_ag_relaxed_coords,
+        point,
+        options
       );
 
-      // Get the coords of the relaxed position
-      // and replace the antigen to the original position
-      hemi_ag_relaxed_coords = ag_coords.row(ag);
-      ag_coords.row(ag) = hemi_ag_orig_coords;
-
       // Check if the hemisphering point is in a new position
       bool equals_original_coords = arma::approx_equal(
         hemi_ag_orig_coords,
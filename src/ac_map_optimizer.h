@@ -0,0 +1,394 @@
+
+#include <RcppArmadillo.h>
+#include "ac_stress.h"
+#include "ac_stress_problem.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifndef Racmacs__ac_map_optimizer__h
+#define Racmacs__ac_map_optimizer__h
+
+// SETUP THE MAP OPTIMIZER CLASS
+// The DIMS template parameter fixes the number of map dimensions at compile
+// time so that the distance and gradient loops in the inner kernel can be
+// fully unrolled, DIMS = 0 is the generic version for any number of dimensions
+template <arma::uword DIMS = 0>
+class MapOptimizer {
+
+  public:
+
+    // ATTRIBUTES
+    // The table data is held by reference to a shared stress problem, only the
+    // coordinates and gradients belong to this optimizer
+    const AcStressProblem &problem;
+    arma::mat ag_coords;
+    arma::mat sr_coords;
+    arma::uword num_dims;
+    arma::uword num_ags;
+    arma::uword num_sr;
+    arma::uvec moveable_ags;
+    arma::uvec moveable_sr;
+    arma::uvec included_ags;
+    arma::uvec included_srs;
+    std::vector<MeasuredPair> included_pairs;
+    const std::vector<MeasuredPair> *measured_pairs;
+    arma::uword num_measurable;
+    double fixed_stress = 0;
+    arma::mat ag_gradients;
+    arma::mat sr_gradients;
+    std::vector<arma::mat> thread_ag_gradients;
+    std::vector<arma::mat> thread_sr_gradients;
+    std::vector<double> thread_stress;
+    int num_threads = 1;
+    double dilution_stepsize;
+    double stress;
+
+    // CONSTRUCTOR FUNCTION
+    // Constructor without fixed points provided
+    MapOptimizer(
+      const AcStressProblem &problem,
+      const arma::mat &ag_start_coords,
+      const arma::mat &sr_start_coords
+    )
+      :problem(problem),
+       ag_coords(ag_start_coords),
+       sr_coords(sr_start_coords),
+       num_dims(ag_start_coords.n_cols),
+       num_ags(problem.num_ags),
+       num_sr(problem.num_sr),
+       dilution_stepsize(problem.dilution_stepsize)
+    {
+
+      // Set default moveable antigens and sera to all
+      moveable_ags = arma::regspace<arma::uvec>(0, num_ags - 1);
+      moveable_sr = arma::regspace<arma::uvec>(0, num_sr - 1);
+
+      // Setup the gradient vectors
+      ag_gradients.zeros(num_ags, num_dims);
+      sr_gradients.zeros(num_sr, num_dims);
+
+      // Index the measured pairs between included points
+      update_measured_pairs();
+
+    }
+
+    // Constructor with fixed points provided
+    MapOptimizer(
+      const AcStressProblem &problem,
+      const arma::mat &ag_start_coords,
+      const arma::mat &sr_start_coords,
+      const arma::uvec &ag_fixed,
+      const arma::uvec &sr_fixed
+    )
+      :problem(problem),
+       ag_coords(ag_start_coords),
+       sr_coords(sr_start_coords),
+       num_dims(ag_start_coords.n_cols),
+       num_ags(problem.num_ags),
+       num_sr(problem.num_sr),
+       dilution_stepsize(problem.dilution_stepsize)
+      {
+
+      // Set moveable antigens
+      moveable_ags = arma::find(ag_fixed == 0);
+      moveable_sr = arma::find(sr_fixed == 0);
+
+      // Setup the gradient vectors
+      ag_gradients.zeros(num_ags, num_dims);
+      sr_gradients.zeros(num_sr, num_dims);
+
+      // Index the measured pairs between included points
+      update_measured_pairs();
+
+    }
+
+    // NUMBER OF DIMENSIONS
+    // A compile time constant for the dimension specialised kernels
+    inline arma::uword dims() const {
+      return DIMS > 0 ? DIMS : num_dims;
+    }
+
+    // EVALUATE OBJECTIVE FUNCTION
+    // This is needed for optimization methods that don't evaluate the gradient
+    double Evaluate(
+        const arma::mat &pars
+    ){
+
+      // Update coords from parameters
+      update_map_coords(pars);
+
+      // Calculate and return the stress
+      return calculate_stress();
+
+    }
+
+    // EVALUATE OBJECTIVE FUNCTION AND UPDATE GRADIENT
+    // This is needed for optimization methods that do evaluate the gradient
+    double EvaluateWithGradient(
+        const arma::mat &pars,
+        arma::mat &grad
+    ){
+
+      // Update coords from parameters
+      update_map_coords(pars);
+
+      // Calculate the stress and gradients in a single pass
+      update_stress_and_gradients();
+
+      // Apply the gradients of moveable points to grad
+      grad.set_size(pars.n_rows, pars.n_cols);
+      for(arma::uword j = 0; j < dims(); ++j) {
+        for(arma::uword i = 0; i < moveable_ags.n_elem; ++i) {
+          grad.at(i, j) = ag_gradients.at(moveable_ags(i), j);
+        }
+        for(arma::uword i = 0; i < moveable_sr.n_elem; ++i) {
+          grad.at(i + moveable_ags.n_elem, j) = sr_gradients.at(moveable_sr(i), j);
+        }
+      }
+
+      // Return the stress
+      return stress;
+
+    }
+
+    // SET THE NUMBER OF THREADS USED PER EVALUATION
+    // Each thread accumulates gradients for its share of the measured pairs
+    // into its own buffers, which are summed at the end of the evaluation.
+    // Threads are capped so that each has a worthwhile number of pairs
+    void set_num_threads(
+      const int &threads
+    ){
+
+      const arma::uword min_pairs_per_thread = 2048;
+      num_threads = threads;
+      if (measured_pairs->size() / min_pairs_per_thread < (arma::uword)num_threads) {
+        num_threads = measured_pairs->size() / min_pairs_per_thread;
+      }
+      if (num_threads < 1) num_threads = 1;
+
+      thread_ag_gradients.assign(num_threads, arma::mat(num_ags, num_dims));
+      thread_sr_gradients.assign(num_threads, arma::mat(num_sr, num_dims));
+      thread_stress.assign(num_threads, 0);
+
+    }
+
+    // CALCULATING STRESS AND STRESS GRADIENTS
+    // Map distances are calculated as each measured pair is visited, so the
+    // table data is only read once per evaluation and no intermediate
+    // distance matrix is stored
+    void update_stress_and_gradients() {
+
+      // Measured pairs are grouped by titer type so each group can be passed
+      // to the batch stress functions
+      arma::uword num_pairs = measured_pairs->size();
+
+      if (num_threads == 1) {
+
+        ag_gradients.zeros();
+        sr_gradients.zeros();
+        stress = fixed_stress;
+        stress += pair_stress_and_gradients(0, num_measurable, false, ag_gradients, sr_gradients);
+        stress += pair_stress_and_gradients(num_measurable, num_pairs, true, ag_gradients, sr_gradients);
+        return;
+
+      }
+
+      // Split each group of pairs evenly between the threads
+      #pragma omp parallel for schedule(static) num_threads(num_threads)
+      for (int t = 0; t < num_threads; t++) {
+
+        arma::uword m0 = (num_measurable*t) / num_threads;
+        arma::uword m1 = (num_measurable*(t + 1)) / num_threads;
+        arma::uword l0 = num_measurable + ((num_pairs - num_measurable)*t) / num_threads;
+        arma::uword l1 = num_measurable + ((num_pairs - num_measurable)*(t + 1)) / num_threads;
+
+        thread_ag_gradients[t].zeros();
+        thread_sr_gradients[t].zeros();
+        thread_stress[t] = pair_stress_and_gradients(m0, m1, false, thread_ag_gradients[t], thread_sr_gradients[t]);
+        thread_stress[t] += pair_stress_and_gradients(l0, l1, true, thread_ag_gradients[t], thread_sr_gradients[t]);
+
+      }
+
+      // Reduce the thread results, always in the same order so the result
+      // does not depend on thread scheduling
+      stress = fixed_stress;
+      ag_gradients.zeros();
+      sr_gradients.zeros();
+      for (int t = 0; t < num_threads; t++) {
+        stress += thread_stress[t];
+        ag_gradients += thread_ag_gradients[t];
+        sr_gradients += thread_sr_gradients[t];
+      }
+
+    }
+
+    // Calculate stress and accumulate gradients for a range of measured pairs
+    // that share the same titer type, working through them in fixed size blocks
+    double pair_stress_and_gradients(
+      const arma::uword &first,
+      const arma::uword &last,
+      const bool &lessthan,
+      arma::mat &ag_grads,
+      arma::mat &sr_grads
+    ) const {
+
+      const arma::uword block_size = 256;
+      double map_dists[block_size];
+      double table_dists[block_size];
+      double weights[block_size];
+      double ibases[block_size];
+      double gradient;
+      double range_stress = 0;
+
+      for(arma::uword start = first; start < last; start += block_size) {
+
+        // Calculate the map distances for the block
+        arma::uword n = last - start;
+        if (n > block_size) n = block_size;
+        for(arma::uword k = 0; k < n; ++k) {
+          const MeasuredPair &pair = (*measured_pairs)[start + k];
+          map_dists[k] = pair_dist(pair);
+          table_dists[k] = pair.table_dist;
+          weights[k] = pair.weight;
+        }
+
+        // Calculate the stress and inc_base for the whole block
+        if (lessthan) {
+          range_stress += ac_lessthan_stress_block(
+            map_dists, table_dists, weights, ibases, n, dilution_stepsize
+          );
+        } else {
+          range_stress += ac_measurable_stress_block(
+            map_dists, table_dists, weights, ibases, n
+          );
+        }
+
+        // Now calculate the gradient for each coordinate
+        for(arma::uword k = 0; k < n; ++k) {
+          const MeasuredPair &pair = (*measured_pairs)[start + k];
+          for(arma::uword i = 0; i < dims(); ++i) {
+            gradient = ibases[k]*(ag_coords.at(pair.ag, i) - sr_coords.at(pair.sr, i));
+            ag_grads.at(pair.ag, i) -= gradient;
+            sr_grads.at(pair.sr, i) += gradient;
+          }
+        }
+
+      }
+
+      return range_stress;
+
+    }
+
+    // CALCULATING MAP STRESS
+    double calculate_stress(){
+
+      // Set the start stress
+      stress = fixed_stress;
+
+      // Now we cycle through and sum up the stresses
+      for(auto &pair : *measured_pairs) {
+        double map_dist = pair_dist(pair);
+        stress += pair.weight * ac_ptStress(
+          map_dist,
+          pair.table_dist,
+          pair.titer_type,
+          dilution_stepsize
+        );
+      }
+
+      // Return the map stress
+      return stress;
+
+    }
+
+    // CALCULATE THE MAP DISTANCE FOR A MEASURED PAIR
+    inline double pair_dist(
+      const MeasuredPair &pair
+    ) const {
+
+      double dist = 0;
+      for(arma::uword i = 0; i < dims(); ++i) {
+        double diff = ag_coords.at(pair.ag, i) - sr_coords.at(pair.sr, i);
+        dist += diff*diff;
+      }
+      return sqrt(dist);
+
+    }
+
+    // UPDATE MAP COORDINATES FROM PARAMETERS
+    void update_map_coords(
+      const arma::mat &pars
+    ){
+
+      for(arma::uword j = 0; j < dims(); ++j) {
+        for(arma::uword i = 0; i < moveable_ags.n_elem; ++i) {
+          ag_coords.at(moveable_ags(i),j) = pars.at(i, j);
+        }
+      }
+
+      for(arma::uword j = 0; j < dims(); ++j) {
+        for(arma::uword i = 0; i < moveable_sr.n_elem; ++i) {
+          sr_coords.at(moveable_sr(i),j) = pars.at(i + moveable_ags.n_elem, j);
+        }
+      }
+
+    }
+
+    // INDEX THE MEASURED PAIRS
+    // Points with non-finite coordinates are excluded from the optimization,
+    // when all points are included and moveable the shared index from the
+    // stress problem is used directly, otherwise a filtered copy is made for
+    // this optimizer. Pairs between two fixed points contribute a constant
+    // stress, so this is calculated once here and only pairs with at least
+    // one moveable point are evaluated during the optimization
+    void update_measured_pairs(){
+
+      // Set included antigens and sera
+      included_ags = arma::find_finite(ag_coords.col(0));
+      included_srs = arma::find_finite(sr_coords.col(0));
+      fixed_stress = 0;
+
+      if (
+          included_ags.n_elem == num_ags && included_srs.n_elem == num_sr &&
+          moveable_ags.n_elem == num_ags && moveable_sr.n_elem == num_sr
+      ) {
+        measured_pairs = &problem.measured_pairs;
+        num_measurable = problem.num_measurable;
+        return;
+      }
+
+      arma::uvec ag_included(num_ags, arma::fill::zeros);
+      arma::uvec sr_included(num_sr, arma::fill::zeros);
+      arma::uvec ag_moveable(num_ags, arma::fill::zeros);
+      arma::uvec sr_moveable(num_sr, arma::fill::zeros);
+      ag_included.elem(included_ags).ones();
+      sr_included.elem(included_srs).ones();
+      ag_moveable.elem(moveable_ags).ones();
+      sr_moveable.elem(moveable_sr).ones();
+
+      included_pairs.clear();
+      num_measurable = 0;
+      for(arma::uword i = 0; i < problem.measured_pairs.size(); ++i) {
+        const MeasuredPair &pair = problem.measured_pairs[i];
+        if (ag_included(pair.ag) == 0 || sr_included(pair.sr) == 0) continue;
+        if (ag_moveable(pair.ag) == 0 && sr_moveable(pair.sr) == 0) {
+          fixed_stress += pair.weight * ac_ptStress(
+            pair_dist(pair),
+            pair.table_dist,
+            pair.titer_type,
+            dilution_stepsize
+          );
+          continue;
+        }
+        included_pairs.push_back(pair);
+        if (i < problem.num_measurable) num_measurable++;
+      }
+      measured_pairs = &included_pairs;
+
+    }
+
+};
+
+#endif
@@ -0,0 +1,113 @@
+
+#include <RcppArmadillo.h>
+#include "ac_stress_problem.h"
+#include "ac_mds.h"
+
+// Complete the table distances between all antigens and sera, antigens first
+// then sera. Only antigen to serum distances are measured, so distances
+// between pairs of antigens and pairs of sera are estimated as the shortest
+// path through a serum or antigen they share, and unmeasured antigen to serum
+// distances as the shortest path through another serum. Any pairs still not
+// connected are set to the largest distance found
+arma::mat ac_completed_table_distances(
+    const AcStressProblem &problem
+){
+
+  arma::uword num_ags = problem.num_ags;
+  arma::uword num_sr = problem.num_sr;
+  double inf = arma::datum::inf;
+
+  // Measured antigen to serum distances, less than titers count at their
+  // threshold distance
+  arma::mat ag_sr_dists(num_ags, num_sr);
+  ag_sr_dists.fill(inf);
+  for (auto &pair : problem.measured_pairs) {
+    ag_sr_dists.at(pair.ag, pair.sr) = pair.table_dist;
+  }
+
+  // Antigen to antigen distances through a shared serum
+  arma::mat ag_ag_dists(num_ags, num_ags);
+  ag_ag_dists.fill(inf);
+  for (arma::uword sr = 0; sr < num_sr; sr++) {
+    for (arma::uword ag1 = 0; ag1 < num_ags; ag1++) {
+      double d1 = ag_sr_dists.at(ag1, sr);
+      if (d1 == inf) continue;
+      for (arma::uword ag2 = 0; ag2 < num_ags; ag2++) {
+        double d = d1 + ag_sr_dists.at(ag2, sr);
+        if (d < ag_ag_dists.at(ag2, ag1)) ag_ag_dists.at(ag2, ag1) = d;
+      }
+    }
+  }
+  ag_ag_dists.diag().zeros();
+
+  // Serum to serum distances through a shared antigen
+  arma::mat sr_sr_dists(num_sr, num_sr);
+  sr_sr_dists.fill(inf);
+  for (arma::uword sr1 = 0; sr1 < num_sr; sr1++) {
+    for (arma::uword sr2 = 0; sr2 < num_sr; sr2++) {
+      for (arma::uword ag = 0; ag < num_ags; ag++) {
+        double d = ag_sr_dists.at(ag, sr1) + ag_sr_dists.at(ag, sr2);
+        if (d < sr_sr_dists.at(sr1, sr2)) sr_sr_dists.at(sr1, sr2) = d;
+      }
+    }
+  }
+  sr_sr_dists.diag().zeros();
+
+  // Unmeasured antigen to serum distances through another serum
+  arma::mat completed_ag_sr_dists = ag_sr_dists;
+  for (arma::uword sr = 0; sr < num_sr; sr++) {
+    for (arma::uword ag = 0; ag < num_ags; ag++) {
+      if (ag_sr_dists.at(ag, sr) != inf) continue;
+      double dmin = inf;
+      for (arma::uword sr2 = 0; sr2 < num_sr; sr2++) {
+        double d = ag_sr_dists.at(ag, sr2) + sr_sr_dists.at(sr2, sr);
+        if (d < dmin) dmin = d;
+      }
+      completed_ag_sr_dists.at(ag, sr) = dmin;
+    }
+  }
+
+  // Put together the full matrix
+  arma::mat dists = arma::join_cols(
+    arma::join_rows(ag_ag_dists, completed_ag_sr_dists),
+    arma::join_rows(completed_ag_sr_dists.t(), sr_sr_dists)
+  );
+
+  // Fill any remaining gaps
+  arma::uvec finite_dists = arma::find_finite(dists);
+  double max_dist = finite_dists.n_elem > 0 ? dists.elem(finite_dists).max() : 1.0;
+  dists.elem(arma::find_nonfinite(dists)).fill(max_dist);
+
+  return dists;
+
+}
+
+
+// Classical multidimensional scaling of the completed table distances,
+// returning coordinates for antigens followed by sera
+arma::mat ac_table_mds_coords(
+    const AcStressProblem &problem,
+    const arma::uword &num_dims
+){
+
+  // Double center the squared distances
+  arma::mat dists = ac_completed_table_distances(problem);
+  arma::mat b = -0.5*arma::square(dists);
+  b.each_col() -= arma::mean(b, 1);
+  b.each_row() -= arma::mean(b, 0);
+
+  // Take the largest eigenvalues, which eig_sym returns last
+  arma::vec eigval;
+  arma::mat eigvec;
+  arma::eig_sym(eigval, eigvec, b);
+
+  arma::uword n = eigval.n_elem;
+  arma::mat coords(n, num_dims, arma::fill::zeros);
+  for (arma::uword i = 0; i < num_dims && i < n; i++) {
+    double lambda = eigval(n - 1 - i);
+    if (lambda > 0) coords.col(i) = eigvec.col(n - 1 - i)*std::sqrt(lambda);
+  }
+
+  return coords;
+
+}
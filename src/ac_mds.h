@@ -0,0 +1,19 @@
+
+#include <RcppArmadillo.h>
+#include "ac_stress_problem.h"
+
+#ifndef Racmacs__ac_mds__h
+#define Racmacs__ac_mds__h
+
+// Complete the table distances between all antigens and sera
+arma::mat ac_completed_table_distances(
+    const AcStressProblem &problem
+);
+
+// Classical multidimensional scaling of the completed table distances
+arma::mat ac_table_mds_coords(
+    const AcStressProblem &problem,
+    const arma::uword &num_dims
+);
+
+#endif
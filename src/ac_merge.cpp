@@ -114,6 +114,223 @@ AcTiter ac_merge_titers(
 
 }
 
+// Merge the titers from each layer for a single antigen and serum, giving
+// the same results as ac_merge_titers(), ac_titer_merge_type() and the sd of
+// log titers. Only titers stored in the sparse layers are passed, layers
+// where the titer is "*" count as a single "*", since only whether there
+// are any and not how many affects the results
+static void merge_layer_titers(
+    const AcTiter *titers,
+    const arma::uword &num_stored,
+    const arma::uword &num_layers,
+    const bool &lispmds,
+    const bool &likelihood,
+    const double &sd_limit,
+    const double &dilution_stepsize,
+    double *log_titers,
+    AcTiter &merged_titer,
+    int &merge_type,
+    double &sd
+){
+
+  // Count the titer types and get log titers of the measured titers
+  arma::uword num_titers = num_stored + (num_stored < num_layers);
+  arma::uword num_omitted = 0;
+  arma::uword num_detectable = 0;
+  arma::uword num_lessthan = 0;
+  arma::uword num_morethan = 0;
+  arma::uword num_measured = 0;
+  double min_numeric = arma::datum::inf;
+  double max_numeric = -arma::datum::inf;
+  double max_log_titer = -arma::datum::inf;
+
+  for (arma::uword i=0; i<num_stored; i++) {
+
+    const AcTiter &titer = titers[i];
+    if (titer.type == -1) num_omitted++;
+    if (titer.type <= 0) continue;
+
+    double log_titer = std::log2(titer.numeric / 10.0);
+    switch (titer.type) {
+    case 1:
+      num_detectable++;
+      break;
+    case 2:
+      num_lessthan++;
+      log_titer -= dilution_stepsize;
+      break;
+    case 3:
+      num_morethan++;
+      log_titer += dilution_stepsize;
+      break;
+    }
+
+    if (titer.numeric < min_numeric) min_numeric = titer.numeric;
+    if (titer.numeric > max_numeric) max_numeric = titer.numeric;
+    if (log_titer > max_log_titer) max_log_titer = log_titer;
+    log_titers[num_measured++] = log_titer;
+
+  }
+
+  // Type of merge
+  if      (num_omitted == num_titers)    merge_type = -1;
+  else if (num_measured == 0)            merge_type = 0;
+  else if (num_detectable == num_titers) merge_type = 1;
+  else if (num_lessthan == num_titers)   merge_type = 2;
+  else if (num_morethan == num_titers)   merge_type = 3;
+  else                                   merge_type = 4;
+
+  // View onto the log titers of the measured titers in the workspace
+  const arma::vec measured_log_titers(log_titers, num_measured, false, true);
+
+  // Sd of log titers across all layers, undefined if any are not measured
+  if      (num_layers < 2)              sd = 0;
+  else if (num_measured < num_titers)   sd = arma::datum::nan;
+  else                                  sd = arma::stddev(measured_log_titers);
+
+  // Merged titer, following the rules in ac_merge_titers()
+  if (num_layers == 1) {
+    merged_titer = titers[0];
+  } else if (num_lessthan > 0 && num_morethan > 0) {
+    merged_titer = AcTiter();
+  } else if (num_omitted == num_titers) {
+    merged_titer = AcTiter(0, -1);
+  } else if (num_measured == 0) {
+    merged_titer = AcTiter();
+  } else if (num_lessthan == num_measured) {
+    merged_titer = AcTiter(min_numeric, 2);
+  } else if (num_morethan == num_measured) {
+    merged_titer = AcTiter(max_numeric, 3);
+  } else if (
+      sd_limit == sd_limit &&
+      arma::stddev(measured_log_titers, lispmds) > sd_limit
+  ) {
+    merged_titer = AcTiter();
+  } else if (!likelihood && num_lessthan > 0) {
+    merged_titer = AcTiter(
+      std::pow(2.0, max_log_titer + dilution_stepsize)*10,
+      2
+    );
+  } else {
+    merged_titer = AcTiter(
+      std::pow(2.0, arma::mean(measured_log_titers))*10,
+      1
+    );
+  }
+
+}
+
+// Merge titer layers, finding the merged titers, merge types and sd of log
+// titers in one pass. Layers are converted to their sparse form and then
+// sera are merged, both in parallel. Each thread gathers the titers stored
+// for a serum in the sparse layers into its own workspace, so there is no
+// allocation for each titer
+AcTiterLayerMerge ac_titer_layer_merge(
+    const std::vector<AcTiterTable>& titer_layers,
+    const std::string& method,
+    const double& sd_limit,
+    const double& dilution_stepsize,
+    const int& num_cores
+){
+
+  arma::uword num_ags = titer_layers.at(0).nags();
+  arma::uword num_sr  = titer_layers.at(0).nsr();
+  arma::uword num_layers = titer_layers.size();
+  bool lispmds = method == "lispmds";
+  bool likelihood = method == "likelihood";
+
+  std::vector<AcSparseTiterTable> layers(num_layers);
+
+  // Titers that are "*" in every layer stay "*", are not measured and have
+  // no sd, unless there is only the one layer
+  arma::mat merged_numeric(num_ags, num_sr, arma::fill::zeros);
+  arma::imat merged_types(num_ags, num_sr, arma::fill::zeros);
+  AcTiterLayerMerge merge {
+    AcTiterTable(num_ags, num_sr),
+    arma::imat(num_ags, num_sr, arma::fill::zeros),
+    arma::mat(num_ags, num_sr)
+  };
+  merge.sd.fill(num_layers > 1 ? arma::datum::nan : 0);
+
+  #pragma omp parallel num_threads(std::max(num_cores, 1))
+  {
+
+    // Convert the layers to their sparse form, a layer at a time
+    #pragma omp for schedule(dynamic)
+    for (int i=0; i<(int)num_layers; i++) {
+      layers[i] = AcSparseTiterTable(titer_layers[i]);
+    }
+
+    // Workspace for the thread, reused for every serum
+    std::vector<arma::uword> ag_counts(num_ags, 0);
+    std::vector<arma::uword> ag_next(num_ags);
+    std::vector<arma::uword> stored_ags;
+    std::vector<AcTiter> sr_titers;
+    std::vector<double> log_titers(num_layers);
+    stored_ags.reserve(num_ags);
+
+    #pragma omp for schedule(dynamic)
+    for (int sr=0; sr<(int)num_sr; sr++) {
+
+      // Count the titers stored for each antigen across the layers
+      for (auto &layer : layers) {
+        for (arma::uword i=layer.col_start(sr); i<layer.col_end(sr); i++) {
+          if (ag_counts[layer.ag_index(i)]++ == 0) stored_ags.push_back(layer.ag_index(i));
+        }
+      }
+
+      // Gather the titers for each antigen together, in layer order
+      arma::uword num_stored = 0;
+      for (auto ag : stored_ags) {
+        ag_next[ag] = num_stored;
+        num_stored += ag_counts[ag];
+      }
+      if (sr_titers.size() < num_stored) sr_titers.resize(num_stored);
+      for (auto &layer : layers) {
+        for (arma::uword i=layer.col_start(sr); i<layer.col_end(sr); i++) {
+          sr_titers[ag_next[layer.ag_index(i)]++] = layer.titer(i);
+        }
+      }
+
+      // Merge the titers for each antigen
+      for (auto ag : stored_ags) {
+
+        AcTiter merged_titer;
+        int merge_type;
+        double sd;
+        merge_layer_titers(
+          &sr_titers[ag_next[ag] - ag_counts[ag]],
+          ag_counts[ag],
+          num_layers,
+          lispmds,
+          likelihood,
+          sd_limit,
+          dilution_stepsize,
+          log_titers.data(),
+          merged_titer,
+          merge_type,
+          sd
+        );
+
+        merged_numeric(ag, sr) = merged_titer.numeric;
+        merged_types(ag, sr) = merged_titer.type;
+        merge.merge_types(ag, sr) = merge_type;
+        merge.sd(ag, sr) = sd;
+        ag_counts[ag] = 0;
+
+      }
+      stored_ags.clear();
+
+    }
+
+  }
+
+  merge.titers.set_numeric_titers(merged_numeric);
+  merge.titers.set_titer_types(merged_types);
+  return merge;
+
+}
+
 // For merging titer layers
 // [[Rcpp::export]]
 AcTiterTable ac_merge_titer_layers(
@@ -121,33 +338,76 @@ AcTiterTable ac_merge_titer_layers(
     const AcMergeOptions& options
 ){
 
-  int num_ags = titer_layers.at(0).nags();
-  int num_sr  = titer_layers.at(0).nsr();
-  int num_layers = titer_layers.size();
+  // A user specified merge function is called for every titer, with the
+  // titers from every layer, this can only be done from the main thread
+  if (options.method == "function") {
 
-  AcTiterTable merged_table = AcTiterTable(
-    num_ags,
-    num_sr
-  );
+    int num_ags = titer_layers.at(0).nags();
+    int num_sr  = titer_layers.at(0).nsr();
+    int num_layers = titer_layers.size();
 
-  std::vector<AcTiter> titers(num_layers, AcTiter());
+    AcTiterTable merged_table = AcTiterTable(
+      num_ags,
+      num_sr
+    );
 
-  for(int ag=0; ag<num_ags; ag++){
-    for(int sr=0; sr<num_sr; sr++){
-      for(int i=0; i<num_layers; i++){
-        titers[i] = titer_layers.at(i).get_titer(ag,sr);
+    std::vector<AcTiter> titers(num_layers, AcTiter());
+    for(int ag=0; ag<num_ags; ag++){
+      for(int sr=0; sr<num_sr; sr++){
+        for(int i=0; i<num_layers; i++){
+          titers[i] = titer_layers.at(i).get_titer(ag,sr);
+        }
+        merged_table.set_titer(
+          ag, sr,
+          ac_merge_titers(
+            titers,
+            options
+          )
+        );
       }
-      merged_table.set_titer(
-        ag, sr,
-        ac_merge_titers(
-          titers,
-          options
-        )
-      );
     }
+    return merged_table;
+
   }
 
-  return merged_table;
+  // Otherwise use the parallel merge
+  return ac_titer_layer_merge(
+    titer_layers,
+    options.method,
+    options.sd_limit,
+    options.dilution_stepsize,
+    options.num_cores
+  ).titers;
+
+}
+
+
+// Merge titer layers, returning the merged titers along with the merge types
+// and sd of log titers, so that all three come from a single merge
+// [[Rcpp::export]]
+Rcpp::List ac_titer_layer_merge_all(
+    const std::vector<AcTiterTable>& titer_layers,
+    const AcMergeOptions& options
+){
+
+  // The merge method does not affect the merge types or sd, so a user
+  // specified merge function only needs to be used for the titers
+  AcTiterLayerMerge merge = ac_titer_layer_merge(
+    titer_layers,
+    options.method == "function" ? "conservative" : options.method,
+    options.sd_limit,
+    options.dilution_stepsize,
+    options.num_cores
+  );
+  if (options.method == "function") {
+    merge.titers = ac_merge_titer_layers(titer_layers, options);
+  }
+
+  return Rcpp::List::create(
+    Rcpp::_["titers"] = merge.titers,
+    Rcpp::_["merge_types"] = merge.merge_types,
+    Rcpp::_["sd"] = merge.sd
+  );
 
 }
 
@@ -658,24 +918,26 @@ AcMap ac_merge_incremental_single(
     arma::fill::zeros
   );
 
-  // Get table distance matrix and titer type matrix
-  arma::mat tabledist_matrix = merged_map.titer_table_flat.numeric_table_distances(
-    min_colbasis,
-    fixed_colbases,
-    ag_reactivity_adjustments
+  // Setup the stress problem shared between the runs
+  AcStressProblem problem(
+    merged_map.titer_table_flat.numeric_table_distances(
+      min_colbasis,
+      fixed_colbases,
+      ag_reactivity_adjustments
+    ),
+    merged_map.titer_table_flat.get_titer_types()
   );
-  arma::imat titertype_matrix = merged_map.titer_table_flat.get_titer_types();
 
   // Generate optimizations with random starting coords
   std::vector<AcOptimization> optimizations = ac_generateOptimizations(
-    tabledist_matrix,
-    titertype_matrix,
+    problem,
     min_colbasis,
     fixed_colbases,
     ag_reactivity_adjustments,
     num_dims,
     num_optimizations,
-    optimizer_options
+    optimizer_options,
+    ac_rng_seed()
   );
 
   // Set coordinates of points found in map 1 back to their positions in map1
@@ -695,8 +957,7 @@ AcMap ac_merge_incremental_single(
   ac_relaxOptimizations(
     optimizations,
     optimizations.at(0).dim(),
-    tabledist_matrix,
-    titertype_matrix,
+    problem,
     optimizer_options
   );
 
@@ -815,26 +1076,18 @@ int ac_titer_merge_type(
 // Determing the type of titer merge happening in tables
 // [[Rcpp::export]]
 arma::imat ac_titer_layer_merge_types(
-    const std::vector<AcTiterTable>& titer_layers
+    const std::vector<AcTiterTable>& titer_layers,
+    const int num_cores = 1
 ){
 
-  int num_ags = titer_layers.at(0).nags();
-  int num_sr  = titer_layers.at(0).nsr();
-  int num_layers = titer_layers.size();
-
-  arma::imat merge_types(num_ags, num_sr);
-  std::vector<AcTiter> titers(num_layers, AcTiter());
-
-  for (int ag=0; ag<num_ags; ag++) {
-    for (int sr=0; sr<num_sr; sr++) {
-      for (int i=0; i<num_layers; i++) {
-        titers[i] = titer_layers.at(i).get_titer(ag,sr);
-      }
-      merge_types(ag, sr) = ac_titer_merge_type(titers);
-    }
-  }
-
-  return merge_types;
+  // The merge method does not affect the merge types
+  return ac_titer_layer_merge(
+    titer_layers,
+    "conservative",
+    arma::datum::nan,
+    1.0,
+    num_cores
+  ).merge_types;
 
 }
 
@@ -843,25 +1096,17 @@ arma::imat ac_titer_layer_merge_types(
 // [[Rcpp::export]]
 arma::mat ac_titer_layer_sd(
     const std::vector<AcTiterTable>& titer_layers,
-    const double dilution_stepsize
+    const double dilution_stepsize,
+    const int num_cores = 1
 ){
 
-  int num_ags = titer_layers.at(0).nags();
-  int num_sr  = titer_layers.at(0).nsr();
-  int num_layers = titer_layers.size();
-
-  arma::mat merge_sd(num_ags, num_sr);
-  std::vector<AcTiter> titers(num_layers, AcTiter());
-
-  for (int ag=0; ag<num_ags; ag++) {
-    for (int sr=0; sr<num_sr; sr++) {
-      for (int i=0; i<num_layers; i++) {
-        titers[i] = titer_layers.at(i).get_titer(ag,sr);
-      }
-      merge_sd(ag, sr) = arma::stddev(log_titers(titers, dilution_stepsize));
-    }
-  }
-
-  return merge_sd;
+  // The merge method does not affect the sd of log titers
+  return ac_titer_layer_merge(
+    titer_layers,
+    "conservative",
+    arma::datum::nan,
+    dilution_stepsize,
+    num_cores
+  ).sd;
 
 }
@@ -11,6 +11,7 @@ struct AcMergeOptions {
   double dilution_stepsize;
   Rcpp::Function merge_function;
   std::string method;
+  int num_cores;
 };
 
 
@@ -21,6 +22,25 @@ AcTiter ac_merge_titers(
 );
 
 
+// Merged titers along with the type of merge and sd of log titers for each
+// titer across the layers
+struct AcTiterLayerMerge {
+  AcTiterTable titers;
+  arma::imat merge_types;
+  arma::mat sd;
+};
+
+
+// Merge titer layers, finding merged titers, merge types and sds together
+AcTiterLayerMerge ac_titer_layer_merge(
+    const std::vector<AcTiterTable>& titer_layers,
+    const std::string& method,
+    const double& sd_limit,
+    const double& dilution_stepsize,
+    const int& num_cores
+);
+
+
 // Merge titer layers
 AcTiterTable ac_merge_titer_layers(
     const std::vector<AcTiterTable>& titer_layers,
@@ -1,5 +1,8 @@
 
 #include <math.h>
+#include <chrono>
+#include <functional>
+#include <memory>
 #include <RcppArmadillo.h>
 #include <RcppEnsmallen.h>
 
@@ -15,6 +18,14 @@
 #include "utils_progress.h"
 #include "acmap_map.h"
 #include "ac_stress.h"
+#include "ac_stress_problem.h"
+#include "ac_optimizer_race.h"
+#include "ac_optimizer_convergence.h"
+#include "ac_optimizer_checkpoint.h"
+#include "ac_optimizer_telemetry.h"
+#include "ac_rng.h"
+#include "ac_mds.h"
+#include "ac_map_optimizer.h"
 #include "ac_optim_map_stress.h"
 #include "ac_optimization.h"
 #include "ac_optimizer_options.h"
@@ -22,278 +33,6 @@
 #include "acmap_titers.h"
 
 
-// SETUP THE MAP OPTIMIZER CLASS
-class MapOptimizer {
-
-  public:
-
-    // ATTRIBUTES
-    arma::mat ag_coords;
-    arma::mat sr_coords;
-    arma::mat tabledist_matrix;
-    arma::imat titertype_matrix;
-    arma::mat mapdist_matrix;
-    arma::uword num_dims;
-    arma::uword num_ags;
-    arma::uword num_sr;
-    arma::uvec moveable_ags;
-    arma::uvec moveable_sr;
-    arma::uvec included_ags;
-    arma::uvec included_srs;
-    arma::uvec::iterator agi;
-    arma::uvec::iterator agi_end;
-    arma::uvec::iterator sri;
-    arma::uvec::iterator sri_end;
-    arma::mat titer_weights;
-    arma::mat ag_gradients;
-    arma::mat sr_gradients;
-    double dilution_stepsize;
-    double gradient;
-    double stress;
-
-    // CONSTRUCTOR FUNCTION
-    // Constructor without fixed points provided
-    MapOptimizer(
-      arma::mat ag_start_coords,
-      arma::mat sr_start_coords,
-      arma::mat tabledist,
-      arma::imat titertype,
-      arma::uword dims,
-      double dilution_stepsize
-    )
-      :ag_coords(ag_start_coords),
-       sr_coords(sr_start_coords),
-       tabledist_matrix(tabledist),
-       titertype_matrix(titertype),
-       num_dims(dims),
-       num_ags(tabledist.n_rows),
-       num_sr(tabledist.n_cols),
-       dilution_stepsize(dilution_stepsize)
-    {
-
-      // Set default moveable antigens and sera to all
-      moveable_ags = arma::regspace<arma::uvec>(0, num_ags - 1);
-      moveable_sr = arma::regspace<arma::uvec>(0, num_sr - 1);
-
-      // Set included antigens and sera
-      included_ags = arma::find_finite(ag_start_coords.col(0));
-      included_srs = arma::find_finite(sr_start_coords.col(0));
-      agi_end = included_ags.end();
-      sri_end = included_srs.end();
-
-      // Set default weights to 1
-      titer_weights.ones(num_ags, num_sr);
-
-      // Setup map dist matrices
-      mapdist_matrix = arma::mat(num_ags, num_sr, arma::fill::zeros);
-
-      // Setup the gradient vectors
-      ag_gradients.zeros(num_ags, num_dims);
-      sr_gradients.zeros(num_sr, num_dims);
-
-      // Update the map distance matrix according to coordinates
-      update_map_dist_matrix();
-
-    }
-
-    // Constructor with fixed points provided
-    MapOptimizer(
-      arma::mat ag_start_coords,
-      arma::mat sr_start_coords,
-      arma::mat tabledist,
-      arma::imat titertype,
-      arma::uword dims,
-      arma::uvec ag_fixed,
-      arma::uvec sr_fixed,
-      arma::mat titer_weights_in,
-      double dilution_stepsize
-    )
-      :ag_coords(ag_start_coords),
-       sr_coords(sr_start_coords),
-       tabledist_matrix(tabledist),
-       titertype_matrix(titertype),
-       num_dims(dims),
-       num_ags(tabledist.n_rows),
-       num_sr(tabledist.n_cols),
-       dilution_stepsize(dilution_stepsize)
-      {
-
-      // Set default weights to 1 if missing
-      if (titer_weights_in.n_elem == 0) titer_weights.ones(num_ags, num_sr);
-      else                              titer_weights = titer_weights_in;
-
-      // Set moveable antigens
-      moveable_ags = arma::find(ag_fixed == 0);
-      moveable_sr = arma::find(sr_fixed == 0);
-
-      // Set included antigens and sera
-      included_ags = arma::find_finite(ag_start_coords.col(0));
-      included_srs = arma::find_finite(sr_start_coords.col(0));
-      agi_end = included_ags.end();
-      sri_end = included_srs.end();
-
-      // Setup map dist matrices
-      mapdist_matrix = arma::mat(num_ags, num_sr, arma::fill::zeros);
-
-      // Setup the gradient vectors
-      ag_gradients.zeros(num_ags, num_dims);
-      sr_gradients.zeros(num_sr, num_dims);
-
-      // Update the map distance matrix according to coordinates
-      update_map_dist_matrix();
-
-    }
-
-    // EVALUATE OBJECTIVE FUNCTION
-    // This is needed for optimization methods that don't evaluate the gradient
-    double Evaluate(
-        const arma::mat &pars
-    ){
-
-      // Update coords from parameters
-      update_map_coords(pars);
-
-      // Update the distance matrix according to the new coords
-      update_map_dist_matrix();
-
-      // Calculate and return the stress
-      return calculate_stress();
-
-    }
-
-    // EVALUATE OBJECTIVE FUNCTION AND UPDATE GRADIENT
-    // This is needed for optimization methods that do evaluate the gradient
-    double EvaluateWithGradient(
-        const arma::mat &pars,
-        arma::mat &grad
-    ){
-
-      // Update coords from parameters
-      update_map_coords(pars);
-
-      // Update the gradients and distance matrix according to the new coords
-      update_map_dist_matrix();
-      update_gradients();
-
-      // Apply the gradients of moveable points to grad
-      grad = arma::join_cols(
-        ag_gradients.rows( moveable_ags ),
-        sr_gradients.rows( moveable_sr )
-      );
-
-      // Calculate and return the stress
-      return calculate_stress();
-
-    }
-
-    // CALCULATING STRESS GRADIENTS
-    void update_gradients() {
-
-      // Setup to update gradients
-      ag_gradients.zeros();
-      sr_gradients.zeros();
-
-      // Now we cycle through each antigen and sera and calculate the gradient
-      for(sri = included_srs.begin(); sri != sri_end; ++sri) {
-        for(agi = included_ags.begin(); agi != agi_end; ++agi) {
-
-          // Skip unmeasured titers
-          if(titertype_matrix.at(*agi, *sri) <= 0){
-            continue;
-          }
-
-          // Calculate inc_base
-          double ibase = titer_weights.at(*agi,*sri) * inc_base(
-            mapdist_matrix.at(*agi, *sri),
-            tabledist_matrix.at(*agi, *sri),
-            titertype_matrix.at(*agi, *sri),
-            dilution_stepsize
-          );
-
-          // Now calculate the gradient for each coordinate
-          for(arma::uword i = 0; i < num_dims; ++i) {
-            gradient = ibase*(ag_coords.at(*agi, i) - sr_coords.at(*sri, i));
-            ag_gradients.at(*agi, i) -= gradient;
-            sr_gradients.at(*sri, i) += gradient;
-          }
-
-        }
-      }
-
-    }
-
-    // CALCULATING MAP STRESS
-    double calculate_stress(){
-
-      // Set the start stress
-      stress = 0;
-
-      // Now we cycle through and sum up the stresses
-      for(sri = included_srs.begin(); sri != sri_end; ++sri) {
-        for(agi = included_ags.begin(); agi != agi_end; ++agi) {
-
-          // Skip unmeasured titers
-          if(titertype_matrix.at(*agi,*sri) <= 0){
-            continue;
-          }
-
-          // Now calculate the stress
-          stress += titer_weights.at(*agi,*sri) * ac_ptStress(
-            mapdist_matrix.at(*agi,*sri),
-            tabledist_matrix.at(*agi,*sri),
-            titertype_matrix.at(*agi,*sri),
-            dilution_stepsize
-          );
-
-        }
-      }
-
-      // Return the map stress
-      return stress;
-
-    }
-
-    // UPDATE MAP COORDINATES FROM PARAMETERS
-    void update_map_coords(
-      const arma::mat &pars
-    ){
-
-      for(arma::uword j = 0; j < num_dims; ++j) {
-        for(arma::uword i = 0; i < moveable_ags.n_elem; ++i) {
-          ag_coords.at(moveable_ags(i),j) = pars.at(i, j);
-        }
-      }
-
-      for(arma::uword j = 0; j < num_dims; ++j) {
-        for(arma::uword i = 0; i < moveable_sr.n_elem; ++i) {
-          sr_coords.at(moveable_sr(i),j) = pars.at(i + moveable_ags.n_elem, j);
-        }
-      }
-
-    }
-
-    // UPDATE THE MAP DISTANCE MATRIX
-    void update_map_dist_matrix(){
-
-      for(sri = included_srs.begin(); sri != sri_end; ++sri) {
-        for(agi = included_ags.begin(); agi != agi_end; ++agi) {
-
-          // Only calculate distances where ag and sr were titrated
-          if(titertype_matrix.at(*agi,*sri) <= 0) continue;
-
-          // Calculate the euclidean distance
-          mapdist_matrix.at(*agi,*sri) = sqrt(arma::accu(arma::square(
-            ag_coords.row(*agi) - sr_coords.row(*sri)
-          )));
-
-        }
-      }
-
-    }
-
-};
-
-
 // [[Rcpp::export]]
 double ac_coords_stress(
     const AcTiterTable &titers,
@@ -305,21 +44,21 @@ double ac_coords_stress(
     double dilution_stepsize
 ){
 
-  // Set variables
-  int num_dims = ag_coords.n_cols;
-
-  // Create the map object for the map optimizer
-  MapOptimizer map(
-      ag_coords,
-      sr_coords,
-      titers.numeric_table_distances(
-        min_colbasis,
-        fixed_colbases,
-        ag_reactivity_adjustments
-      ),
-      titers.get_titer_types(),
-      num_dims,
-      dilution_stepsize
+  // Create the stress problem and map optimizer
+  AcStressProblem problem(
+    titers.numeric_table_distances(
+      min_colbasis,
+      fixed_colbases,
+      ag_reactivity_adjustments
+    ),
+    titers.get_titer_types(),
+    arma::mat(),
+    dilution_stepsize
+  );
+  MapOptimizer<> map(
+    problem,
+    ag_coords,
+    sr_coords
   );
 
   // Calculate and return the stress
@@ -413,40 +152,32 @@ arma::mat ac_point_residuals(
 }
 
 
-// [[Rcpp::export]]
-double ac_relax_coords(
-    const arma::mat &tabledist_matrix,
-    const arma::imat &titertype_matrix,
+// Relax coordinates using the map optimizer kernel specialised to a given
+// number of dimensions
+template <arma::uword DIMS>
+double relax_coords(
+    const AcStressProblem &problem,
     arma::mat &ag_coords,
     arma::mat &sr_coords,
     const AcOptimizerOptions &options,
-    const arma::uvec &fixed_antigens,
-    const arma::uvec &fixed_sera,
-    const arma::mat &titer_weights,
-    const double &dilution_stepsize
+    const arma::uvec &ag_fixed,
+    const arma::uvec &sr_fixed,
+    AcRaceCallback *race,
+    AcOptimizerTelemetry *telemetry
 ){
 
-  // Do not move antigens and sera with NA coords
-  arma::uvec ag_fixed(ag_coords.n_rows, arma::fill::zeros);
-  arma::uvec sr_fixed(sr_coords.n_rows, arma::fill::zeros);
-  ag_fixed.elem(fixed_antigens).ones();
-  sr_fixed.elem(fixed_sera).ones();
-  ag_fixed.elem(arma::find_nonfinite(ag_coords.col(0))).ones();
-  sr_fixed.elem(arma::find_nonfinite(sr_coords.col(0))).ones();
-
   // Create the map object for the map optimizer
-  MapOptimizer map(
+  MapOptimizer<DIMS> map(
+    problem,
     ag_coords,
     sr_coords,
-    tabledist_matrix,
-    titertype_matrix,
-    ag_coords.n_cols,
     ag_fixed,
-    sr_fixed,
-    titer_weights,
-    dilution_stepsize
+    sr_fixed
   );
 
+  // Set the number of cores used for each evaluation
+  map.set_num_threads(options.num_eval_cores);
+
   // Create the vector of parameters
   arma::mat pars = arma::join_cols(
     ag_coords.rows(arma::find(ag_fixed == 0)),
@@ -466,8 +197,26 @@ double ac_relax_coords(
     options.max_step
   );
 
-  // Perform the optimization
-  lbfgs.Optimize(map, pars);
+  // Perform the optimization, racing it against other runs if requested
+  AcTelemetryCallback telemetry_callback;
+  auto start_time = std::chrono::steady_clock::now();
+  if (race) {
+    lbfgs.Optimize(map, pars, telemetry_callback, *race);
+  } else {
+    lbfgs.Optimize(map, pars, telemetry_callback);
+  }
+  std::chrono::duration<double> run_time = std::chrono::steady_clock::now() - start_time;
+
+  // Record telemetry on the relaxation
+  if (telemetry) {
+    *telemetry = AcOptimizerTelemetry();
+    telemetry->iterations = telemetry_callback.iterations;
+    telemetry->evaluations = telemetry_callback.evaluations;
+    telemetry->line_search_failures = telemetry_callback.line_search_failures;
+    telemetry->termination = telemetry_callback.termination;
+    if (race && race->abandoned) telemetry->termination = "abandoned";
+    telemetry->time = run_time.count();
+  }
 
   // Return the result
   ag_coords = map.ag_coords;
@@ -477,66 +226,211 @@ double ac_relax_coords(
 }
 
 
-// Generate a bunch of optimizations with randomized coordinates
-// this is a starting point for later relaxation
-std::vector<AcOptimization> ac_generateOptimizations(
+// Relax coordinates against a stress problem shared between runs
+double ac_relax_coords(
+    const AcStressProblem &problem,
+    arma::mat &ag_coords,
+    arma::mat &sr_coords,
+    const AcOptimizerOptions &options,
+    const arma::uvec &fixed_antigens,
+    const arma::uvec &fixed_sera,
+    AcRaceCallback *race,
+    AcOptimizerTelemetry *telemetry
+){
+
+  // Do not move antigens and sera with NA coords
+  arma::uvec ag_fixed(ag_coords.n_rows, arma::fill::zeros);
+  arma::uvec sr_fixed(sr_coords.n_rows, arma::fill::zeros);
+  ag_fixed.elem(fixed_antigens).ones();
+  sr_fixed.elem(fixed_sera).ones();
+  ag_fixed.elem(arma::find_nonfinite(ag_coords.col(0))).ones();
+  sr_fixed.elem(arma::find_nonfinite(sr_coords.col(0))).ones();
+
+  // Dispatch to the kernel for the number of map dimensions, 2 and 3
+  // dimensional maps get their own specialised versions
+  switch(ag_coords.n_cols) {
+  case 2:
+    return relax_coords<2>(problem, ag_coords, sr_coords, options, ag_fixed, sr_fixed, race, telemetry);
+  case 3:
+    return relax_coords<3>(problem, ag_coords, sr_coords, options, ag_fixed, sr_fixed, race, telemetry);
+  default:
+    return relax_coords<0>(problem, ag_coords, sr_coords, options, ag_fixed, sr_fixed, race, telemetry);
+  }
+
+}
+
+
+// [[Rcpp::export]]
+double ac_relax_coords(
     const arma::mat &tabledist_matrix,
     const arma::imat &titertype_matrix,
+    arma::mat &ag_coords,
+    arma::mat &sr_coords,
+    const AcOptimizerOptions &options,
+    const arma::uvec &fixed_antigens,
+    const arma::uvec &fixed_sera,
+    const arma::mat &titer_weights,
+    const double &dilution_stepsize
+){
+
+  AcStressProblem problem(
+    tabledist_matrix,
+    titertype_matrix,
+    titer_weights,
+    dilution_stepsize
+  );
+
+  return ac_relax_coords(
+    problem,
+    ag_coords,
+    sr_coords,
+    options,
+    fixed_antigens,
+    fixed_sera
+  );
+
+}
+
+
+// Work out the size of the box random starting coordinates are placed in, by
+// running a rough optimization using max table dist as the box size
+double ac_startBoxsize(
+    const AcStressProblem &problem,
     const std::string &min_colbasis,
     const arma::vec &fixed_colbases,
     const arma::vec &ag_reactivity_adjustments,
     const int &num_dims,
-    const int &num_optimizations,
     const AcOptimizerOptions &options,
-    const double &dilution_stepsize
+    const uint64_t &seed
 ){
 
-  // Infer number of antigens and sera
-  int num_ags = tabledist_matrix.n_rows;
-  int num_sr = tabledist_matrix.n_cols;
-
-  // First run a rough optimization using max table dist as the box size
   AcOptimization initial_optim = AcOptimization(
     num_dims,
-    num_ags,
-    num_sr,
+    problem.num_ags,
+    problem.num_sr,
     min_colbasis,
     fixed_colbases,
     ag_reactivity_adjustments
   );
 
-  initial_optim.randomizeCoords( tabledist_matrix.max() );
-  initial_optim.relax_from_raw_matrices(
-    tabledist_matrix,
-    titertype_matrix,
-    options,
-    arma::uvec(),
-    arma::uvec(),
-    arma::mat(),
-    dilution_stepsize
+  // Random numbers come from a separate stream for each run, stream 0 is used
+  // for this initial optimization
+  AcRng initial_rng(seed, 0);
+  initial_optim.randomizeCoords( problem.tabledist_matrix.max(), initial_rng );
+  initial_optim.relax_from_stress_problem(
+    problem,
+    options
   );
 
   // Set boxsize based on initial optimization result
   arma::mat distmat = initial_optim.distance_matrix();
   double coord_maxdist = distmat.max();
-  double coord_boxsize = coord_maxdist*2;
+  return coord_maxdist*2;
+
+}
+
+
+// Generate a single optimization with randomized coordinates, run i draws
+// from random number stream i + 1
+AcOptimization ac_generateOptimization(
+    const AcStressProblem &problem,
+    const std::string &min_colbasis,
+    const arma::vec &fixed_colbases,
+    const arma::vec &ag_reactivity_adjustments,
+    const int &num_dims,
+    const double &boxsize,
+    const uint64_t &seed,
+    const int &run
+){
+
+  AcOptimization optimization(
+      num_dims,
+      problem.num_ags,
+      problem.num_sr,
+      min_colbasis,
+      fixed_colbases,
+      ag_reactivity_adjustments
+  );
+
+  AcRng rng(seed, run + 1);
+  optimization.randomizeCoords(boxsize, rng);
+  return optimization;
+
+}
+
+
+// Generate a single optimization starting from coordinates of a classical MDS
+// embedding of the table, with normally distributed noise of the given
+// standard deviation added. Run i draws from random number stream i + 1
+AcOptimization ac_generateMdsOptimization(
+    const AcStressProblem &problem,
+    const std::string &min_colbasis,
+    const arma::vec &fixed_colbases,
+    const arma::vec &ag_reactivity_adjustments,
+    const arma::mat &mds_coords,
+    const double &noise_sd,
+    const uint64_t &seed,
+    const int &run
+){
+
+  AcOptimization optimization(
+      mds_coords.n_cols,
+      problem.num_ags,
+      problem.num_sr,
+      min_colbasis,
+      fixed_colbases,
+      ag_reactivity_adjustments
+  );
+
+  AcRng rng(seed, run + 1);
+  arma::mat coords = mds_coords + rng.randn<arma::mat>(mds_coords.n_rows, mds_coords.n_cols)*noise_sd;
+  optimization.set_ag_base_coords(coords.rows(0, problem.num_ags - 1));
+  optimization.set_sr_base_coords(coords.rows(problem.num_ags, coords.n_rows - 1));
+  return optimization;
+
+}
+
+
+// Generate a bunch of optimizations with randomized coordinates
+// this is a starting point for later relaxation
+std::vector<AcOptimization> ac_generateOptimizations(
+    const AcStressProblem &problem,
+    const std::string &min_colbasis,
+    const arma::vec &fixed_colbases,
+    const arma::vec &ag_reactivity_adjustments,
+    const int &num_dims,
+    const int &num_optimizations,
+    const AcOptimizerOptions &options,
+    const uint64_t &seed
+){
+
+  // Work out the box size for random coordinates
+  double coord_boxsize = ac_startBoxsize(
+    problem,
+    min_colbasis,
+    fixed_colbases,
+    ag_reactivity_adjustments,
+    num_dims,
+    options,
+    seed
+  );
 
   // Create starting optimizations with random coordinates
   std::vector<AcOptimization> optimizations;
+  optimizations.reserve(num_optimizations);
   for(int i=0; i<num_optimizations; i++){
-
-    AcOptimization optimization(
-        num_dims,
-        num_ags,
-        num_sr,
+    optimizations.push_back(
+      ac_generateOptimization(
+        problem,
         min_colbasis,
         fixed_colbases,
-        ag_reactivity_adjustments
+        ag_reactivity_adjustments,
+        num_dims,
+        coord_boxsize,
+        seed,
+        i
+      )
     );
-
-    optimization.randomizeCoords(coord_boxsize);
-    optimizations.push_back(optimization);
-
   }
 
   // Return the randomized optimizations
@@ -545,77 +439,359 @@ std::vector<AcOptimization> ac_generateOptimizations(
 }
 
 
-// Relax the optimizations generated randomly
-void ac_relaxOptimizations(
+// Work out the stages of relaxation, when dimensional annealing runs are first
+// relaxed in each of the annealing dimensions above the final number of
+// dimensions, using that stage's iteration limit and tolerances, before a
+// final relaxation in the final number of dimensions with the main options
+std::vector<std::pair<arma::uword, AcOptimizerOptions>> ac_relaxationStages(
+    const AcOptimizerOptions &options,
+    const arma::uword &num_dims
+){
+
+  std::vector<std::pair<arma::uword, AcOptimizerOptions>> stages;
+  if (options.dim_annealing) {
+    for (arma::uword i=0; i<options.annealing_dims.n_elem; i++) {
+      if (options.annealing_dims(i) <= num_dims) continue;
+      AcOptimizerOptions stage_options = options;
+      stage_options.maxit = options.annealing_maxit(i);
+      stage_options.factr = options.annealing_factr(i);
+      stage_options.min_gradient_norm = options.annealing_min_gradient_norm(i);
+      stages.push_back(std::make_pair(options.annealing_dims(i), stage_options));
+    }
+  }
+  stages.push_back(std::make_pair(num_dims, options));
+  return stages;
+
+}
+
+
+// Relax the optimizations generated randomly, if a start generator is given
+// it is called to set up each of num_starts optimizations on the worker that
+// relaxes it, and the optimizations are added to the vector. If a checkpoint
+// is given runs already recorded in it are restored rather than rerun, and
+// newly completed runs are recorded. The number of runs completed is returned
+arma::uword ac_relaxOptimizations(
   std::vector<AcOptimization>& optimizations,
   arma::uword num_dims,
-  const arma::mat &tabledist_matrix,
-  const arma::imat &titertype_matrix,
+  const AcStressProblem &problem,
   const AcOptimizerOptions &options,
-  const arma::mat &titer_weights,
-  const double &dilution_stepsize
+  const std::function<AcOptimization(const int&)> &generate_start,
+  const int &num_starts,
+  AcOptimizerCheckpoint *checkpoint
 ){
 
   // Set variables
   int num_optimizations = optimizations.size();
+  if (generate_start) {
+    optimizations.clear();
+    num_optimizations = num_starts;
+  }
 
-  // Set progress bar
-  if(options.report_progress) REprintf("Performing %d optimizations\n", num_optimizations);
-  AcProgressBar pb(options.progress_bar_length, options.report_progress);
-  Progress p(num_optimizations, true, pb);
-
-  // Set dimensions to cycle through, for e.g. dimensional annealing
-  arma::uvec dim_set { num_dims };
-  if (options.dim_annealing) {
-    dim_set.set_size(2);
-    dim_set(0) = 5;
-    dim_set(1) = num_dims;
+  // Report the runs to be performed
+  if(options.report_progress) {
+    if (options.time_budget > 0) {
+      REprintf("Performing up to %d optimizations within %g seconds\n", num_optimizations, options.time_budget);
+    } else {
+      REprintf("Performing %d optimizations\n", num_optimizations);
+    }
   }
 
-  // Run and return optimization results
-  #pragma omp parallel for schedule(dynamic) num_threads(options.num_cores)
-  for (int i=0; i<num_optimizations; i++) {
+  // Set dimensions to cycle through, for e.g. dimensional annealing
+  std::vector<std::pair<arma::uword, AcOptimizerOptions>> stages = ac_relaxationStages(
+    options,
+    num_dims
+  );
 
-    // Run the optimization
-    if (!p.check_abort()) {
+  // If each relaxation is itself split across cores, perform the
+  // optimization runs one at a time
+  int num_run_cores = options.num_cores;
+  if (options.num_eval_cores > 1) num_run_cores = 1;
+
+  // Setup the race between optimization runs, only the final stage of any
+  // dimensional annealing is raced since stresses from earlier stages are not
+  // comparable with the final ones
+  AcOptimizerRace race(options);
+
+  // Setup the heap of best runs if only the best are to be kept
+  AcOptimizationHeap best_optimizations(optimizations, options.keep_best);
+
+  // Setup the check for convergence, when stopping on convergence the number
+  // of optimizations is the maximum number of runs and no more are started
+  // once the best stress has been reproduced by enough runs
+  AcOptimizerConvergence convergence(options);
+
+  // Setup the time budget
+  auto start_time = std::chrono::steady_clock::now();
+  auto elapsed_time = [&]() {
+    return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start_time
+    ).count();
+  };
+  auto out_of_time = [&]() {
+    return options.time_budget > 0 && elapsed_time() >= options.time_budget;
+  };
+
+  // Set progress bar, with a time budget the number of runs that will be
+  // performed is not known so the bar shows the fraction of the budget used
+  const int time_budget_steps = 1000;
+  int time_budget_steps_done = 0;
+  AcProgressBar pb(options.progress_bar_length, options.report_progress);
+  Progress p(options.time_budget > 0 ? time_budget_steps : num_optimizations, true, pb);
+  auto increment_progress = [&]() {
+    if (options.time_budget > 0) {
+      int steps = std::min(
+        static_cast<int>(time_budget_steps*elapsed_time()/options.time_budget),
+        time_budget_steps
+      );
+      if (steps > time_budget_steps_done) {
+        p.increment(steps - time_budget_steps_done);
+        time_budget_steps_done = steps;
+      }
+    } else {
       p.increment();
+    }
+  };
 
-      // Now cycle "anneal" through the dimensions
-      for (arma::uword j=0; j<dim_set.n_elem; j++) {
+  // Make storage for the runs, with a time budget storage is only made for
+  // the runs actually performed as they complete
+  if (generate_start && options.time_budget <= 0) {
+    optimizations.resize(num_optimizations, AcOptimization(0, 0, 0));
+  }
+  arma::uvec abandoned(optimizations.size(), arma::fill::zeros);
+  arma::uvec completed(optimizations.size(), arma::fill::zeros);
+
+  // Run and return optimization results, each worker claims the next run
+  // until all have been claimed or the runs are interrupted, converge or run
+  // out of time. Runs are relaxed separately and only claiming and storing
+  // them is synchronised
+  int next_run = 0;
+  #pragma omp parallel num_threads(num_run_cores)
+  {
+    while (true) {
+
+      // Claim the next run
+      int i = -1;
+      AcOptimization optimization(0, 0, 0);
+      #pragma omp critical(ac_relax_optimizations)
+      {
+        if (
+            next_run < num_optimizations &&
+            !p.check_abort() &&
+            !convergence.has_converged() &&
+            !out_of_time()
+        ) {
+          i = next_run++;
+          if (!generate_start) optimization = std::move(optimizations.at(i));
+        }
+      }
+      if (i < 0) break;
+
+      // Generate the starting coordinates, runs recorded in the checkpoint
+      // are restored from it rather than relaxed
+      bool run_abandoned = false;
+      bool restored = checkpoint && checkpoint->completed_runs().count(i) > 0;
+      if (generate_start) optimization = generate_start(i);
+      if (restored) {
+        const AcCheckpointRun &run = checkpoint->completed_runs().at(i);
+        if (!generate_start) {
+          if (optimization.dim() > static_cast<int>(num_dims)) {
+            optimization.reduceDimensions(num_dims);
+          }
+          optimization.set_ag_base_coords(run.ag_base_coords);
+          optimization.set_sr_base_coords(run.sr_base_coords);
+          optimization.stress = run.stress;
+        }
+        run_abandoned = run.abandoned;
+        if (options.racing && !run.abandoned) race.add_result(run.stress);
+      }
+
+      // Now cycle "anneal" through the dimensions, adding up the telemetry
+      // from each stage. Stages in more dimensions than the run starts in
+      // are skipped, otherwise the run is reduced to each stage's dimensions
+      AcOptimizerTelemetry run_telemetry;
+      for (arma::uword j=0; j<stages.size() && !restored; j++) {
+
+        arma::uword stage_dims = stages[j].first;
+        const AcOptimizerOptions &stage_options = stages[j].second;
+        arma::uword run_dims = optimization.dim();
+        if (run_dims < stage_dims) continue;
+        if (run_dims > stage_dims) optimization.reduceDimensions(stage_dims);
 
         // Relax the optimizations
-        optimizations.at(i).relax_from_raw_matrices(
-            tabledist_matrix,
-            titertype_matrix,
-            options,
-            arma::uvec(), // Fixed ags
-            arma::uvec(), // Fixed sr
-            titer_weights,
-            dilution_stepsize
-        );
+        if (options.racing && j == stages.size() - 1) {
+
+          AcRaceCallback race_callback(race, options);
+          optimization.relax_from_stress_problem(
+              problem,
+              stage_options,
+              arma::uvec(),
+              arma::uvec(),
+              &race_callback
+          );
+
+          if (race_callback.abandoned) {
+            run_abandoned = true;
+          } else {
+            race.add_result(optimization.stress);
+          }
+
+        } else {
+
+          optimization.relax_from_stress_problem(
+              problem,
+              stage_options
+          );
 
-        // Reduce dimensions to next step if doing dimensional annealing
-        if (dim_set(j) != num_dims) {
-          optimizations.at(i).reduceDimensions(dim_set(j + 1));
         }
 
+        run_telemetry.add_stage(optimization.telemetry, stage_dims);
+
+      }
+      if (!restored) {
+        optimization.telemetry = run_telemetry;
+        if (checkpoint) checkpoint->add_run(i, optimization, run_abandoned);
       }
 
-    }
+      // Check for convergence
+      if (options.convergence_num_runs > 0 && !run_abandoned) {
+        convergence.add_result(optimization);
+      }
+
+      // Store the run and offer it to the heap of best runs, releasing the
+      // memory of any run that no longer makes the cut
+      #pragma omp critical(ac_relax_optimizations)
+      {
+        if (optimizations.size() <= static_cast<arma::uword>(i)) {
+          optimizations.resize(i + 1, AcOptimization(0, 0, 0));
+          abandoned.resize(i + 1);
+          completed.resize(i + 1);
+        }
+        optimizations.at(i) = std::move(optimization);
+        abandoned(i) = run_abandoned ? 1 : 0;
+        completed(i) = 1;
+
+        if (options.keep_best > 0 && !run_abandoned) {
+          arma::sword discarded = best_optimizations.push(i);
+          if (discarded >= 0) {
+            optimizations.at(discarded) = AcOptimization(0, 0, 0);
+          }
+        }
+
+        increment_progress();
+      }
 
+    }
   }
 
-  // Report finished
+  // Report finished, if interrupted the runs completed so far are returned
+  arma::uword num_completed = arma::accu(completed);
   if (p.is_aborted()) {
-    ac_error("Optimization runs interrupted");
+    REprintf(
+      "\nOptimization runs interrupted, returning the %d runs completed\n",
+      static_cast<int>(num_completed)
+    );
   } else {
     pb.complete("Optimization runs complete");
   }
 
+  if (options.racing && options.report_progress) {
+    REprintf(
+      "%d optimization runs abandoned early\n",
+      static_cast<int>(arma::accu(abandoned))
+    );
+  }
+
+  if (options.convergence_num_runs > 0 && options.report_progress) {
+    if (convergence.has_converged()) {
+      REprintf(
+        "Best stress reproduced by %d runs after %d optimization runs\n",
+        static_cast<int>(convergence.reproductions()),
+        static_cast<int>(num_completed)
+      );
+    } else {
+      REprintf(
+        "Best stress only reproduced by %d of %d runs required, more optimization runs may be needed\n",
+        static_cast<int>(convergence.reproductions()),
+        options.convergence_num_runs
+      );
+    }
+  }
+
+  if (options.time_budget > 0 && options.report_progress) {
+    REprintf(
+      "%d optimization runs completed within the time budget\n",
+      static_cast<int>(num_completed)
+    );
+  }
+
+  // Remove any runs that were abandoned, not run or did not make the best
+  // runs kept
+  std::vector<arma::uword> kept_indices;
+  if (options.keep_best > 0) {
+    kept_indices = best_optimizations.sorted_indices();
+  } else {
+    for (arma::uword i=0; i<completed.n_elem; i++) {
+      if (completed(i) == 1 && abandoned(i) == 0) kept_indices.push_back(i);
+    }
+  }
+
+  if (options.keep_best > 0 || kept_indices.size() < optimizations.size()) {
+    std::vector<AcOptimization> kept_optimizations;
+    kept_optimizations.reserve(kept_indices.size());
+    for (auto &i : kept_indices) {
+      kept_optimizations.push_back(std::move(optimizations.at(i)));
+    }
+    optimizations.swap(kept_optimizations);
+  }
+
+  return num_completed;
+
 }
 
 
-// [[Rcpp::export]]
+// Hash the optimizer options that affect the runs performed and their
+// results, leaving out those such as the number of cores, the time budget and
+// progress reporting that runs can be resumed with different settings for
+uint64_t ac_hashOptimizerOptions(
+    uint64_t hash,
+    const AcOptimizerOptions &options
+){
+
+  hash = ac_hash(hash, static_cast<uint64_t>(options.dim_annealing));
+  hash = ac_hash(hash, options.annealing_dims);
+  hash = ac_hash(hash, options.annealing_maxit);
+  hash = ac_hash(hash, options.annealing_factr);
+  hash = ac_hash(hash, options.annealing_min_gradient_norm);
+  hash = ac_hash(hash, options.method);
+  hash = ac_hash(hash, static_cast<double>(options.maxit));
+  hash = ac_hash(hash, static_cast<double>(options.num_basis));
+  hash = ac_hash(hash, options.armijo_constant);
+  hash = ac_hash(hash, options.wolfe);
+  hash = ac_hash(hash, options.min_gradient_norm);
+  hash = ac_hash(hash, options.factr);
+  hash = ac_hash(hash, static_cast<double>(options.max_line_search_trials));
+  hash = ac_hash(hash, options.min_step);
+  hash = ac_hash(hash, options.max_step);
+  hash = ac_hash(hash, static_cast<uint64_t>(options.racing));
+  hash = ac_hash(hash, static_cast<double>(options.racing_interval));
+  hash = ac_hash(hash, static_cast<double>(options.racing_num_best));
+  hash = ac_hash(hash, options.racing_tolerance);
+  hash = ac_hash(hash, static_cast<double>(options.keep_best));
+  hash = ac_hash(hash, options.start_method);
+  hash = ac_hash(hash, options.start_mds_noise);
+  hash = ac_hash(hash, static_cast<double>(options.convergence_num_runs));
+  hash = ac_hash(hash, options.convergence_tolerance);
+  hash = ac_hash(hash, options.convergence_procrustes_tolerance);
+  return hash;
+
+}
+
+
+// Run optimizations with random numbers drawn from streams of the given seed,
+// numbering runs from first_run so that a batch can be split into shards
+// that each give the same runs as performing the whole batch at once. The box
+// size for random starting coordinates is worked out from the table unless a
+// start_boxsize is given
 std::vector<AcOptimization> ac_runOptimizations(
     const AcTiterTable &titertable,
     const std::string &minimum_col_basis,
@@ -625,47 +801,135 @@ std::vector<AcOptimization> ac_runOptimizations(
     const arma::uword &num_optimizations,
     const AcOptimizerOptions &options,
     const arma::mat &titer_weights,
-    const double &dilution_stepsize
+    const double &dilution_stepsize,
+    const uint64_t &seed,
+    const arma::uword &first_run,
+    const double &start_boxsize
 ){
 
-  // Get table distance matrix and titer type matrix
-  arma::mat tabledist_matrix = titertable.numeric_table_distances(
-    minimum_col_basis,
-    fixed_colbases,
-    ag_reactivity_adjustments
+  // Setup the stress problem, this is shared between all the runs
+  AcStressProblem problem(
+    titertable.numeric_table_distances(
+      minimum_col_basis,
+      fixed_colbases,
+      ag_reactivity_adjustments
+    ),
+    titertable.get_titer_types(),
+    titer_weights,
+    dilution_stepsize
   );
-  arma::imat titertype_matrix = titertable.get_titer_types();
 
-  // Determine the number of dimensions in which to initially randomise
-  arma::uword start_dims;
-  if (options.dim_annealing && num_dims < 5) {
-    start_dims = 5;
+  // Determine the number of dimensions in which to initially randomise, the
+  // dimensions of the first relaxation stage
+  arma::uword start_dims = ac_relaxationStages(options, num_dims).front().first;
+
+  // Resume from or start a checkpoint of completed runs if a checkpoint file
+  // is given, runs resumed from a checkpoint are started from the seed it was
+  // made with so the batch is the same as if it had not been interrupted
+  std::unique_ptr<AcOptimizerCheckpoint> checkpoint;
+  uint64_t start_seed = seed;
+  if (!options.checkpoint_file.empty()) {
+    uint64_t checkpoint_key = ac_hash(0, titertable.get_numeric_titers());
+    checkpoint_key = ac_hash(checkpoint_key, titertable.get_titer_types());
+    checkpoint_key = ac_hash(checkpoint_key, titer_weights);
+    checkpoint_key = ac_hash(checkpoint_key, fixed_colbases);
+    checkpoint_key = ac_hash(checkpoint_key, ag_reactivity_adjustments);
+    checkpoint_key = ac_hash(checkpoint_key, minimum_col_basis);
+    checkpoint_key = ac_hash(checkpoint_key, dilution_stepsize);
+    checkpoint_key = ac_hash(checkpoint_key, static_cast<double>(num_dims));
+    checkpoint_key = ac_hash(checkpoint_key, static_cast<double>(start_dims));
+    checkpoint_key = ac_hash(checkpoint_key, static_cast<double>(first_run));
+    checkpoint_key = ac_hashOptimizerOptions(checkpoint_key, options);
+    checkpoint.reset(
+      new AcOptimizerCheckpoint(options.checkpoint_file, checkpoint_key, seed)
+    );
+    start_seed = checkpoint->get_seed();
+  }
+
+  // Setup generation of the starting coords for each run
+  std::function<AcOptimization(const int&)> generate_start;
+  if (options.start_method == "mds") {
+
+    // Start from perturbed coordinates of a classical MDS embedding
+    arma::mat mds_coords = ac_table_mds_coords(problem, start_dims);
+    generate_start = [&, mds_coords](const int &i) {
+      return ac_generateMdsOptimization(
+        problem,
+        minimum_col_basis,
+        fixed_colbases,
+        ag_reactivity_adjustments,
+        mds_coords,
+        options.start_mds_noise,
+        start_seed,
+        first_run + i
+      );
+    };
+
   } else {
-    start_dims = num_dims;
+
+    // Work out the box size for random starting coords unless one is given,
+    // the rough optimization draws from stream 0 of the seed
+    double boxsize = start_boxsize;
+    if (std::isnan(boxsize)) {
+      boxsize = ac_startBoxsize(
+        problem,
+        minimum_col_basis,
+        fixed_colbases,
+        ag_reactivity_adjustments,
+        start_dims,
+        options,
+        start_seed
+      );
+    }
+
+    generate_start = [&, boxsize](const int &i) {
+      return ac_generateOptimization(
+        problem,
+        minimum_col_basis,
+        fixed_colbases,
+        ag_reactivity_adjustments,
+        start_dims,
+        boxsize,
+        start_seed,
+        first_run + i
+      );
+    };
+
   }
 
-  // Generate optimizations with random starting coords
-  std::vector<AcOptimization> optimizations = ac_generateOptimizations(
-    tabledist_matrix,
-    titertype_matrix,
-    minimum_col_basis,
-    fixed_colbases,
-    ag_reactivity_adjustments,
-    start_dims,
-    num_optimizations,
-    options,
-    dilution_stepsize
-  );
+  // Runs recorded in the checkpoint are built directly from the coordinates
+  // it holds, rather than generating a start only to replace it
+  if (checkpoint) {
+    std::function<AcOptimization(const int&)> generate_new_start = generate_start;
+    generate_start = [&, generate_new_start](const int &i) {
+      auto run = checkpoint->completed_runs().find(i);
+      if (run == checkpoint->completed_runs().end()) return generate_new_start(i);
+      AcOptimization optimization(
+        run->second.ag_base_coords.n_cols,
+        problem.num_ags,
+        problem.num_sr,
+        minimum_col_basis,
+        fixed_colbases,
+        ag_reactivity_adjustments
+      );
+      optimization.set_ag_base_coords(run->second.ag_base_coords);
+      optimization.set_sr_base_coords(run->second.sr_base_coords);
+      optimization.stress = run->second.stress;
+      return optimization;
+    };
+  }
 
-  // Relax the optimizations
+  // Relax the optimizations, each start is generated by the worker that
+  // relaxes it and added to the vector of optimizations
+  std::vector<AcOptimization> optimizations;
   ac_relaxOptimizations(
     optimizations,
     num_dims,
-    tabledist_matrix,
-    titertype_matrix,
+    problem,
     options,
-    titer_weights,
-    dilution_stepsize
+    generate_start,
+    num_optimizations,
+    checkpoint.get()
   );
 
   // Sort the optimizations by stress
@@ -680,51 +944,104 @@ std::vector<AcOptimization> ac_runOptimizations(
 }
 
 
-// //' @export
-// // [[Rcpp::export]]
-// Rcpp::NumericVector benchmark_relaxation(
-//     const arma::mat &tabledist_matrix,
-//     const arma::imat &titertype_matrix,
-//     arma::mat ag_coords,
-//     arma::mat sr_coords,
-//     const std::string method = "L-BFGS-B",
-//     const int maxit = 10000
-// ){
-//
-//   // Set variables
-//   int num_dims = ag_coords.n_cols;
-//   int num_ags  = ag_coords.n_rows;
-//   int num_sr   = sr_coords.n_rows;
-//   int parnum;
-//
-//   // Create the map object for the map optimizer
-//   MapOptimizer map(
-//       ag_coords,
-//       sr_coords,
-//       tabledist_matrix,
-//       titertype_matrix,
-//       num_dims
-//   );
-//
-//   // Create the vector of parameters
-//   arma::vec pars = arma::vec(num_ags*num_dims + num_sr*num_dims);
-//   parnum = 0;
-//
-//   for(int ag = 0; ag < num_ags; ag++){
-//     for(int i = 0; i < num_dims; i++){
-//       pars(parnum) = ag_coords(ag, i);
-//       parnum++;
-//     }
-//   }
-//
-//   for(int sr = 0; sr < num_sr; sr++){
-//     for(int i = 0; i < num_dims; i++){
-//       pars(parnum) = sr_coords(sr, i);
-//       parnum++;
-//     }
-//   }
-//
-//   // Perform benchmarking
-//   return map.benchmark(pars);
-//
-// }
+// [[Rcpp::export]]
+std::vector<AcOptimization> ac_runOptimizations(
+    const AcTiterTable &titertable,
+    const std::string &minimum_col_basis,
+    const arma::vec &fixed_colbases,
+    const arma::vec &ag_reactivity_adjustments,
+    const arma::uword &num_dims,
+    const arma::uword &num_optimizations,
+    const AcOptimizerOptions &options,
+    const arma::mat &titer_weights,
+    const double &dilution_stepsize
+){
+
+  return ac_runOptimizations(
+    titertable,
+    minimum_col_basis,
+    fixed_colbases,
+    ag_reactivity_adjustments,
+    num_dims,
+    num_optimizations,
+    options,
+    titer_weights,
+    dilution_stepsize,
+    ac_rng_seed()
+  );
+
+}
+
+
+
+// Run a shard of a larger batch of optimization runs, seeded from the batch
+// seed so runs are the same as when performing the whole batch at once
+// [[Rcpp::export]]
+std::vector<AcOptimization> ac_runOptimizationShard(
+    const AcTiterTable &titertable,
+    const std::string &minimum_col_basis,
+    const arma::vec &fixed_colbases,
+    const arma::vec &ag_reactivity_adjustments,
+    const arma::uword &num_dims,
+    const arma::uword &first_run,
+    const arma::uword &num_optimizations,
+    const AcOptimizerOptions &options,
+    const arma::mat &titer_weights,
+    const double &dilution_stepsize,
+    const double &seed
+){
+
+  return ac_runOptimizations(
+    titertable,
+    minimum_col_basis,
+    fixed_colbases,
+    ag_reactivity_adjustments,
+    num_dims,
+    num_optimizations,
+    options,
+    titer_weights,
+    dilution_stepsize,
+    static_cast<uint64_t>(seed),
+    first_run
+  );
+
+}
+
+
+// Work out the box size for random starting coordinates of a table, so that
+// repeated optimizations of the same table, for example when fitting antigen
+// reactivities, can share it rather than each running a rough optimization
+// [[Rcpp::export]]
+double ac_tableStartBoxsize(
+    const AcTiterTable &titertable,
+    const std::string &minimum_col_basis,
+    const arma::vec &fixed_colbases,
+    const arma::vec &ag_reactivity_adjustments,
+    const arma::uword &num_dims,
+    const AcOptimizerOptions &options,
+    const arma::mat &titer_weights,
+    const double &dilution_stepsize
+){
+
+  AcStressProblem problem(
+    titertable.numeric_table_distances(
+      minimum_col_basis,
+      fixed_colbases,
+      ag_reactivity_adjustments
+    ),
+    titertable.get_titer_types(),
+    titer_weights,
+    dilution_stepsize
+  );
+
+  return ac_startBoxsize(
+    problem,
+    minimum_col_basis,
+    fixed_colbases,
+    ag_reactivity_adjustments,
+    ac_relaxationStages(options, num_dims).front().first,
+    options,
+    ac_rng_seed()
+  );
+
+}
@@ -1,36 +1,55 @@
 
 # include <RcppArmadillo.h>
+# include <functional>
 # include "acmap_map.h"
 # include "ac_optimizer_options.h"
+# include "ac_stress_problem.h"
+# include "ac_rng.h"
+# include "ac_optimizer_checkpoint.h"
 
 #ifndef Racmacs__ac_optim_map_stress__h
 #define Racmacs__ac_optim_map_stress__h
 
 // Generating optimizations with randomised coords
 std::vector<AcOptimization> ac_generateOptimizations(
-    const arma::mat &tabledist_matrix,
-    const arma::imat &titertype_matrix,
+    const AcStressProblem &problem,
     const std::string &min_colbasis,
     const arma::vec &fixed_colbases,
     const arma::vec &ag_reactivity_adjustments,
     const int &num_dims,
     const int &num_optimizations,
     const AcOptimizerOptions &options,
-    const double &dilution_stepsize = 1.0
+    const uint64_t &seed
 );
 
-// Relaxing optimizations
-void ac_relaxOptimizations(
+// Relaxing optimizations, returning the number of runs completed
+arma::uword ac_relaxOptimizations(
     std::vector<AcOptimization>& optimizations,
     arma::uword num_dims,
-    const arma::mat &tabledist_matrix,
-    const arma::imat &titertype_matrix,
+    const AcStressProblem &problem,
     const AcOptimizerOptions &options,
-    const arma::mat &titer_weights = arma::mat(),
-    const double &dilution_stepsize = 1.0
+    const std::function<AcOptimization(const int&)> &generate_start = nullptr,
+    const int &num_starts = 0,
+    AcOptimizerCheckpoint *checkpoint = nullptr
+);
+
+// Running optimizations, with random numbers drawn from streams of a seed
+std::vector<AcOptimization> ac_runOptimizations(
+    const AcTiterTable &titertable,
+    const std::string &min_colbasis,
+    const arma::vec &fixed_colbases,
+    const arma::vec &ag_reactivity_adjustments,
+    const arma::uword &num_dims,
+    const arma::uword &num_optimizations,
+    const AcOptimizerOptions &options,
+    const arma::mat &titer_weights,
+    const double &dilution_stepsize,
+    const uint64_t &seed,
+    const arma::uword &first_run = 0,
+    const double &start_boxsize = arma::datum::nan
 );
 
-// Running optimizations
+// Running optimizations, with a seed drawn from R's random number generator
 std::vector<AcOptimization> ac_runOptimizations(
     const AcTiterTable &titertable,
     const std::string &min_colbasis,
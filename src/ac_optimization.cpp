@@ -4,8 +4,8 @@
 
 // For optimization sorting
 bool compare_optimization_stress(
-    AcOptimization opt1,
-    AcOptimization opt2
+    const AcOptimization &opt1,
+    const AcOptimization &opt2
 ){
   if(!std::isfinite(opt1.stress)){
     return false;
@@ -42,3 +42,60 @@ void align_optimizations(
 
 }
 
+
+
+// Bounded heap of the best optimizations
+AcOptimizationHeap::AcOptimizationHeap(
+  const std::vector<AcOptimization> &optimizations,
+  const arma::uword &max_size
+)
+  :optimizations(optimizations),
+   max_size(max_size)
+{}
+
+// Offer an optimization to the heap, the index of the optimization that no
+// longer makes the cut is returned, or -1 if none needs to be discarded
+arma::sword AcOptimizationHeap::push(
+  const arma::uword &index
+){
+
+  arma::sword discarded = -1;
+
+  // The heap is ordered so that the worst optimization is at the front
+  auto worse_first = [this](const arma::uword &i, const arma::uword &j) {
+    return compare_optimization_stress(optimizations.at(i), optimizations.at(j));
+  };
+
+  #pragma omp critical(ac_optimization_heap)
+  {
+    if (indices.size() < max_size) {
+      indices.push_back(index);
+      std::push_heap(indices.begin(), indices.end(), worse_first);
+    } else if (compare_optimization_stress(optimizations.at(index), optimizations.at(indices.front()))) {
+      std::pop_heap(indices.begin(), indices.end(), worse_first);
+      discarded = indices.back();
+      indices.back() = index;
+      std::push_heap(indices.begin(), indices.end(), worse_first);
+    } else {
+      discarded = index;
+    }
+  }
+
+  return discarded;
+
+}
+
+// Indices of the optimizations held, from best to worst
+std::vector<arma::uword> AcOptimizationHeap::sorted_indices() const {
+
+  std::vector<arma::uword> sorted(indices);
+  std::sort(
+    sorted.begin(),
+    sorted.end(),
+    [this](const arma::uword &i, const arma::uword &j) {
+      return compare_optimization_stress(optimizations.at(i), optimizations.at(j));
+    }
+  );
+  return sorted;
+
+}
@@ -15,4 +15,33 @@ void align_optimizations(
     std::vector<AcOptimization> &optimizations
 );
 
+
+// A bounded heap keeping track of the best optimizations found so far while
+// they are being relaxed, this is shared between threads so access is
+// synchronised
+class AcOptimizationHeap {
+
+  private:
+    const std::vector<AcOptimization> &optimizations;
+    arma::uword max_size;
+    std::vector<arma::uword> indices;
+
+  public:
+
+    // Constructor
+    AcOptimizationHeap(
+      const std::vector<AcOptimization> &optimizations,
+      const arma::uword &max_size
+    );
+
+    // Offer an optimization by index
+    arma::sword push(
+      const arma::uword &index
+    );
+
+    // Get the indices of the optimizations held, best first
+    std::vector<arma::uword> sorted_indices() const;
+
+};
+
 #endif
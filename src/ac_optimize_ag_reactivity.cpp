@@ -4,6 +4,7 @@
 #include "acmap_titers.h"
 #include "ac_optimization.h"
 #include "ac_optim_map_stress.h"
+#include "ac_rng.h"
 
 // [[Rcpp::export]]
 double ac_reactivity_adjustment_stress(
@@ -21,7 +22,8 @@ double ac_reactivity_adjustment_stress(
     const double &reactivity_stress_weighting,
     const bool reoptimize,
     const arma::uword num_optimizations,
-    const double &dilution_stepsize
+    const double &dilution_stepsize,
+    const double &start_boxsize
 ) {
 
   // Update reactivities with values from par
@@ -32,10 +34,12 @@ double ac_reactivity_adjustment_stress(
   double stress;
   if (reoptimize) {
 
-    // Do not report progress
+    // Do not report progress or checkpoint runs
     options.report_progress = false;
+    options.checkpoint_file = "";
 
-    // Run the optimization
+    // Run the optimization, starting coordinates are placed in the box size
+    // worked out once for the table rather than on every call
     std::vector<AcOptimization> optimizations;
     optimizations = ac_runOptimizations(
       titertable,
@@ -46,7 +50,10 @@ double ac_reactivity_adjustment_stress(
       num_optimizations,
       options,
       titer_weights,
-      dilution_stepsize
+      dilution_stepsize,
+      ac_rng_seed(),
+      0,
+      start_boxsize
     );
 
     // Sort by stress and keep lowest stress
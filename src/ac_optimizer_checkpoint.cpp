@@ -0,0 +1,176 @@
+
+#include <RcppArmadillo.h>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <limits>
+#include <cstdio>
+#include <stdexcept>
+#include "utils_error.h"
+#include "acmap_optimization.h"
+#include "ac_optimizer_checkpoint.h"
+
+// Read a number, throwing if the whole value was not a number, for example
+// when the last value of a line was only partly written
+double read_checkpoint_number(
+  std::istringstream &line
+){
+
+  std::string value;
+  line >> value;
+  std::size_t pos;
+  double number = std::stod(value, &pos);
+  if (pos != value.size()) {
+    throw std::invalid_argument("Incomplete checkpoint value");
+  }
+  return number;
+
+}
+
+// Read coordinates written as a run of numbers
+arma::mat read_checkpoint_coords(
+  std::istringstream &line,
+  const arma::uword &num_rows,
+  const arma::uword &num_cols
+){
+
+  arma::mat coords(num_rows, num_cols);
+  for (arma::uword i=0; i<coords.n_elem; i++) {
+    coords(i) = read_checkpoint_number(line);
+  }
+  return coords;
+
+}
+
+// Write coordinates as a run of numbers
+void write_checkpoint_coords(
+  std::ostringstream &line,
+  const arma::mat &coords
+){
+
+  for (arma::uword i=0; i<coords.n_elem; i++) {
+    line << " " << coords(i);
+  }
+
+}
+
+// Constructor
+AcOptimizerCheckpoint::AcOptimizerCheckpoint(
+  const std::string &path,
+  const uint64_t &key,
+  const uint64_t &seed
+)
+  :path(path),
+   seed(seed)
+{
+
+  // Read any runs already recorded, an empty file, for example from an
+  // interruption before the header was written, is started afresh
+  std::ifstream existing(path);
+  if (existing.good() && existing.peek() != std::ifstream::traits_type::eof()) {
+
+    std::string header;
+    uint64_t file_key;
+    existing >> header >> file_key >> this->seed;
+    if (header != "racmacs_checkpoint" || file_key != key) {
+      ac_error(
+        "Checkpoint file '" + path + "' was not made for this optimization, " +
+        "remove it or choose a different checkpoint file"
+      );
+    }
+
+    // A partially written last line from an interrupted write is ignored,
+    // complete lines end with a ";"
+    std::string text;
+    std::getline(existing, text);
+    while (std::getline(existing, text)) {
+      try {
+        std::istringstream line(text);
+        arma::uword run, num_ags, num_sr, num_dims;
+        AcCheckpointRun checkpoint_run;
+        line >> run >> checkpoint_run.abandoned >> num_ags >> num_sr >> num_dims;
+        checkpoint_run.stress = read_checkpoint_number(line);
+        checkpoint_run.ag_base_coords = read_checkpoint_coords(line, num_ags, num_dims);
+        checkpoint_run.sr_base_coords = read_checkpoint_coords(line, num_sr, num_dims);
+        std::string terminator;
+        line >> terminator;
+        if (line.fail() || terminator != ";") break;
+        runs[run] = checkpoint_run;
+      } catch (const std::exception &e) {
+        break;
+      }
+    }
+    existing.close();
+
+    // Rewrite the file with only the runs read correctly, via a temporary
+    // file so the checkpoint is not lost if this is interrupted
+    std::string tmp_path = path + ".tmp";
+    file.open(tmp_path, std::ios::out | std::ios::trunc);
+    file << "racmacs_checkpoint " << key << " " << this->seed << "\n";
+    for (auto &run : runs) {
+      AcOptimization optimization(
+        run.second.ag_base_coords.n_cols,
+        run.second.ag_base_coords.n_rows,
+        run.second.sr_base_coords.n_rows
+      );
+      optimization.set_ag_base_coords(run.second.ag_base_coords);
+      optimization.set_sr_base_coords(run.second.sr_base_coords);
+      optimization.stress = run.second.stress;
+      add_run(run.first, optimization, run.second.abandoned);
+    }
+    file.close();
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+      ac_error("Could not update checkpoint file '" + path + "'");
+    }
+    file.open(path, std::ios::out | std::ios::app);
+
+  } else {
+
+    file.open(path, std::ios::out | std::ios::trunc);
+    file << "racmacs_checkpoint " << key << " " << seed << "\n";
+
+  }
+
+  if (!file.good()) {
+    ac_error("Could not write to checkpoint file '" + path + "'");
+  }
+  file.flush();
+
+}
+
+// The seed runs were started with
+uint64_t AcOptimizerCheckpoint::get_seed() const {
+  return seed;
+}
+
+// Runs already recorded when the checkpoint was opened
+const std::map<arma::uword, AcCheckpointRun>& AcOptimizerCheckpoint::completed_runs() const {
+  return runs;
+}
+
+// Record a completed run, written as a single line so that runs are recorded
+// whole or not at all
+void AcOptimizerCheckpoint::add_run(
+  const arma::uword &run,
+  const AcOptimization &optimization,
+  const bool &abandoned
+) {
+
+  std::ostringstream line;
+  line.precision(std::numeric_limits<double>::max_digits10);
+  const arma::mat &ag_coords = optimization.get_ag_base_coords();
+  const arma::mat &sr_coords = optimization.get_sr_base_coords();
+  line << run << " " << abandoned << " ";
+  line << ag_coords.n_rows << " " << sr_coords.n_rows << " " << ag_coords.n_cols;
+  line << " " << optimization.stress;
+  write_checkpoint_coords(line, ag_coords);
+  write_checkpoint_coords(line, sr_coords);
+  line << " ;\n";
+
+  #pragma omp critical(ac_optimizer_checkpoint)
+  {
+    file << line.str();
+    file.flush();
+  }
+
+}
@@ -0,0 +1,60 @@
+
+#include <RcppArmadillo.h>
+#include <map>
+#include <fstream>
+#include "acmap_optimization.h"
+
+#ifndef Racmacs__ac_optimizer_checkpoint__h
+#define Racmacs__ac_optimizer_checkpoint__h
+
+// A run recorded in a checkpoint file
+struct AcCheckpointRun
+{
+  bool abandoned;
+  double stress;
+  arma::mat ag_base_coords;
+  arma::mat sr_base_coords;
+};
+
+
+// Records completed optimization runs to a local file as they complete, so
+// that a batch of runs can be resumed from where it got to. The file starts
+// with a key identifying the optimization problem and the seed the runs were
+// started with, followed by a line for each completed run ending with a ";"
+// so that a partially written line can be recognised. Writing is shared
+// between threads so access is synchronised
+class AcOptimizerCheckpoint {
+
+  private:
+    std::string path;
+    std::ofstream file;
+    uint64_t seed;
+    std::map<arma::uword, AcCheckpointRun> runs;
+
+  public:
+
+    // Open the checkpoint file, reading any runs already recorded in it if it
+    // exists for the same problem, otherwise starting a new file with the
+    // given seed
+    AcOptimizerCheckpoint(
+      const std::string &path,
+      const uint64_t &key,
+      const uint64_t &seed
+    );
+
+    // The seed runs were started with
+    uint64_t get_seed() const;
+
+    // Runs already recorded when the checkpoint was opened
+    const std::map<arma::uword, AcCheckpointRun>& completed_runs() const;
+
+    // Record a completed run
+    void add_run(
+      const arma::uword &run,
+      const AcOptimization &optimization,
+      const bool &abandoned
+    );
+
+};
+
+#endif
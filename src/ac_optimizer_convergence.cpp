@@ -0,0 +1,89 @@
+
+#include <RcppArmadillo.h>
+#include "ac_optimizer_options.h"
+#include "ac_optimizer_convergence.h"
+#include "acmap_optimization.h"
+
+// Constructor
+AcOptimizerConvergence::AcOptimizerConvergence(
+  const AcOptimizerOptions &options
+)
+  :num_runs(options.convergence_num_runs),
+   tolerance(options.convergence_tolerance),
+   procrustes_tolerance(options.convergence_procrustes_tolerance)
+{}
+
+// Check whether coordinates match the best coordinates once rotated and
+// translated onto them, points without coordinates are ignored
+bool AcOptimizerConvergence::matches_best(
+  const arma::mat &coords
+) const {
+
+  arma::uvec rows = arma::find(
+    arma::sum(arma::abs(coords) + arma::abs(best_coords), 1) < arma::datum::inf
+  );
+  if (rows.n_elem == 0) return true;
+
+  arma::mat x = coords.rows(rows);
+  arma::mat y = best_coords.rows(rows);
+  x.each_row() -= arma::mean(x, 0);
+  y.each_row() -= arma::mean(y, 0);
+
+  arma::mat u, v;
+  arma::vec d;
+  arma::svd(u, d, v, y.t()*x);
+  arma::mat aligned = x*v*u.t();
+
+  double max_dist = arma::sqrt(arma::sum(arma::square(aligned - y), 1)).max();
+  return max_dist <= procrustes_tolerance;
+
+}
+
+// Record the result of a completed run, stresses within the tolerance of the
+// best, relative to the best stress or absolute below a stress of 1, count as
+// reproducing it if the configuration also matches
+void AcOptimizerConvergence::add_result(
+  const AcOptimization &optimization
+) {
+
+  double stress = optimization.stress;
+  if (!std::isfinite(stress)) return;
+  arma::mat coords = arma::join_cols(
+    optimization.get_ag_base_coords(),
+    optimization.get_sr_base_coords()
+  );
+
+  #pragma omp critical(ac_optimizer_convergence)
+  {
+    double margin = tolerance*std::max(best_stress, 1.0);
+    if (best_coords.n_elem == 0 || stress < best_stress - margin) {
+      best_stress = stress;
+      best_coords = coords;
+      num_reproduced = 1;
+    } else if (stress <= best_stress + margin && matches_best(coords)) {
+      num_reproduced++;
+    }
+    if (num_runs > 0 && num_reproduced >= num_runs) converged = true;
+  }
+
+}
+
+// Whether the best stress has been reproduced by enough runs
+bool AcOptimizerConvergence::has_converged() {
+
+  bool out;
+  #pragma omp critical(ac_optimizer_convergence)
+  out = converged;
+  return out;
+
+}
+
+// The number of runs that have reproduced the best stress
+arma::uword AcOptimizerConvergence::reproductions() {
+
+  arma::uword out;
+  #pragma omp critical(ac_optimizer_convergence)
+  out = num_reproduced;
+  return out;
+
+}
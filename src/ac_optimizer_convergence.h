@@ -0,0 +1,49 @@
+
+#include <RcppArmadillo.h>
+#include "ac_optimizer_options.h"
+#include "acmap_optimization.h"
+
+#ifndef Racmacs__ac_optimizer_convergence__h
+#define Racmacs__ac_optimizer_convergence__h
+
+// Keeps track of whether the best stress found so far has been reproduced by
+// enough runs, ending up in the same configuration, for a batch of
+// optimization runs to be considered converged. This is shared between
+// threads so access is synchronised
+class AcOptimizerConvergence {
+
+  private:
+    arma::uword num_runs;
+    double tolerance;
+    double procrustes_tolerance;
+    double best_stress = arma::datum::inf;
+    arma::mat best_coords;
+    arma::uword num_reproduced = 0;
+    bool converged = false;
+
+    // Check whether coordinates match the best coordinates once aligned
+    bool matches_best(
+      const arma::mat &coords
+    ) const;
+
+  public:
+
+    // Constructor
+    AcOptimizerConvergence(
+      const AcOptimizerOptions &options
+    );
+
+    // Record the result of a completed run
+    void add_result(
+      const AcOptimization &optimization
+    );
+
+    // Whether the best stress has been reproduced by enough runs
+    bool has_converged();
+
+    // The number of runs that have reproduced the best stress
+    arma::uword reproductions();
+
+};
+
+#endif
@@ -1,4 +1,6 @@
 
+#include <RcppArmadillo.h>
+
 #ifndef Racmacs__ac_optimizer_options__h
 #define Racmacs__ac_optimizer_options__h
 
@@ -6,6 +8,10 @@
 struct AcOptimizerOptions {
 
   bool dim_annealing;
+  arma::uvec annealing_dims;
+  arma::ivec annealing_maxit;
+  arma::vec annealing_factr;
+  arma::vec annealing_min_gradient_norm;
   std::string method;
   int maxit;
   int num_basis;
@@ -17,6 +23,19 @@ struct AcOptimizerOptions {
   double min_step;
   double max_step;
   int num_cores;
+  int num_eval_cores;
+  bool racing;
+  int racing_interval;
+  int racing_num_best;
+  double racing_tolerance;
+  int keep_best;
+  std::string start_method;
+  double start_mds_noise;
+  int convergence_num_runs;
+  double convergence_tolerance;
+  double convergence_procrustes_tolerance;
+  double time_budget;
+  std::string checkpoint_file;
   bool report_progress;
   int progress_bar_length;
 
@@ -0,0 +1,46 @@
+
+#include <RcppArmadillo.h>
+#include "ac_optimizer_options.h"
+#include "ac_optimizer_race.h"
+
+// Constructor
+AcOptimizerRace::AcOptimizerRace(
+  const AcOptimizerOptions &options
+)
+  :num_best(options.racing_num_best),
+   tolerance(options.racing_tolerance)
+{}
+
+// Record the final stress of a completed run
+void AcOptimizerRace::add_result(
+  const double &stress
+) {
+
+  if (!std::isfinite(stress)) return;
+
+  #pragma omp critical(ac_optimizer_race)
+  {
+    best_stresses.insert(
+      std::upper_bound(best_stresses.begin(), best_stresses.end(), stress),
+      stress
+    );
+    if (best_stresses.size() > num_best) best_stresses.pop_back();
+  }
+
+}
+
+// The stress above which a run is considered to be losing the race
+double AcOptimizerRace::threshold() {
+
+  double out = arma::datum::inf;
+
+  #pragma omp critical(ac_optimizer_race)
+  {
+    if (num_best > 0 && best_stresses.size() == num_best) {
+      out = best_stresses.back()*(1 + tolerance);
+    }
+  }
+
+  return out;
+
+}
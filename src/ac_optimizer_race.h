@@ -0,0 +1,104 @@
+
+#include <RcppArmadillo.h>
+#include "ac_optimizer_options.h"
+
+#ifndef Racmacs__ac_optimizer_race__h
+#define Racmacs__ac_optimizer_race__h
+
+// Keeps track of the best final stresses of completed optimization runs, so
+// that runs still in progress can be compared against them. This is shared
+// between threads so access is synchronised
+class AcOptimizerRace {
+
+  private:
+    std::vector<double> best_stresses;
+    arma::uword num_best;
+    double tolerance;
+
+  public:
+
+    // Constructor
+    AcOptimizerRace(
+      const AcOptimizerOptions &options
+    );
+
+    // Record the final stress of a completed run
+    void add_result(
+      const double &stress
+    );
+
+    // The stress above which a run is considered to be losing the race, this
+    // is infinite until enough runs have completed
+    double threshold();
+
+};
+
+
+// An ensmallen callback that checkpoints the stress of a run every so many
+// iterations and abandons it if it is clearly doing worse than the best
+// completed runs
+class AcRaceCallback {
+
+  private:
+    AcOptimizerRace &race;
+    arma::uword interval;
+    arma::uword iteration = 0;
+    double checkpoint_stress = arma::datum::inf;
+    double last_stress = arma::datum::inf;
+
+  public:
+
+    bool abandoned = false;
+
+    AcRaceCallback(
+      AcOptimizerRace &race,
+      const AcOptimizerOptions &options
+    )
+      :race(race),
+       interval(options.racing_interval)
+    {}
+
+    // Keep the stress of each evaluation, L-BFGS accepts a step on the last
+    // line search trial so this is the stress at the accepted coordinates
+    // by the time the step is taken
+    template<typename OptimizerType, typename FunctionType, typename MatType, typename GradType>
+    bool EvaluateWithGradient(
+      OptimizerType& optimizer,
+      FunctionType& function,
+      const MatType& coordinates,
+      const double objective,
+      const GradType& gradient
+    ){
+
+      last_stress = objective;
+      return false;
+
+    }
+
+    template<typename OptimizerType, typename FunctionType, typename MatType>
+    bool StepTaken(
+      OptimizerType& optimizer,
+      FunctionType& function,
+      MatType& coordinates
+    ){
+
+      iteration++;
+      if (interval == 0 || iteration % interval != 0) return false;
+
+      // Abandon the run if it is above the threshold and would still be at
+      // the current rate of improvement by the next checkpoint
+      double stress = last_stress;
+      double threshold = race.threshold();
+      double projected_stress = stress - (checkpoint_stress - stress);
+      checkpoint_stress = stress;
+
+      if (stress > threshold && projected_stress > threshold) {
+        abandoned = true;
+      }
+      return abandoned;
+
+    }
+
+};
+
+#endif
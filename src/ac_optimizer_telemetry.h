@@ -0,0 +1,155 @@
+
+#include <RcppArmadillo.h>
+
+#ifndef Racmacs__ac_optimizer_telemetry__h
+#define Racmacs__ac_optimizer_telemetry__h
+
+// Information on how a relaxation went, line search failures are the line
+// search trials that were rejected and the termination reason is one of
+// "gradient_norm", "function_tolerance", "max_iterations",
+// "line_search_failed", "non_finite_stress" or "abandoned". When a run is
+// relaxed in stages, e.g. with dimensional annealing, the number of
+// dimensions and time taken for each stage are also kept
+struct AcOptimizerTelemetry
+{
+  arma::uword iterations = 0;
+  arma::uword evaluations = 0;
+  arma::uword line_search_failures = 0;
+  std::string termination;
+  double time = 0;
+  arma::uvec stage_dims;
+  arma::vec stage_time;
+
+  // Add on the telemetry from a further relaxation of the same run
+  void add(
+    const AcOptimizerTelemetry &stage
+  ){
+    iterations += stage.iterations;
+    evaluations += stage.evaluations;
+    line_search_failures += stage.line_search_failures;
+    termination = stage.termination;
+    time += stage.time;
+  }
+
+  // Add on the telemetry from a further relaxation stage in the given
+  // number of dimensions
+  void add_stage(
+    const AcOptimizerTelemetry &stage,
+    const arma::uword &num_dims
+  ){
+    add(stage);
+    stage_dims.resize(stage_dims.n_elem + 1);
+    stage_dims(stage_dims.n_elem - 1) = num_dims;
+    stage_time.resize(stage_time.n_elem + 1);
+    stage_time(stage_time.n_elem - 1) = stage.time;
+  }
+
+};
+
+
+// An ensmallen callback that records telemetry on an L-BFGS relaxation as it
+// happens. Evaluations are counted as the optimizer makes them, so stress
+// calculations made outside the optimizer are not included, and every line
+// search trial that is not accepted as the next step counts as a line search
+// failure. The reason the optimizer stopped is set once it finishes
+class AcTelemetryCallback {
+
+  private:
+    bool started = false;
+    arma::uword trials = 0;
+    double last_stress = arma::datum::nan;
+    double step_stress = arma::datum::nan;
+    arma::mat step_coords;
+
+  public:
+
+    arma::uword iterations = 0;
+    arma::uword evaluations = 0;
+    arma::uword line_search_failures = 0;
+    std::string termination;
+
+    template<typename OptimizerType, typename FunctionType, typename MatType>
+    void BeginOptimization(
+      OptimizerType& optimizer,
+      FunctionType& function,
+      MatType& coordinates
+    ){
+
+      step_coords = coordinates;
+
+    }
+
+    // The first evaluation is of the starting coordinates, after that each
+    // evaluation is a line search trial for the next step
+    template<typename OptimizerType, typename FunctionType, typename MatType, typename GradType>
+    bool EvaluateWithGradient(
+      OptimizerType& optimizer,
+      FunctionType& function,
+      const MatType& coordinates,
+      const double objective,
+      const GradType& gradient
+    ){
+
+      evaluations++;
+      last_stress = objective;
+      if (started) {
+        trials++;
+      } else {
+        started = true;
+        step_stress = objective;
+      }
+      return false;
+
+    }
+
+    // A step is taken on the last line search trial, any trials before it
+    // were rejected
+    template<typename OptimizerType, typename FunctionType, typename MatType>
+    bool StepTaken(
+      OptimizerType& optimizer,
+      FunctionType& function,
+      MatType& coordinates
+    ){
+
+      iterations++;
+      if (trials > 0) line_search_failures += trials - 1;
+      trials = 0;
+      step_stress = last_stress;
+      step_coords = coordinates;
+      return false;
+
+    }
+
+    // If no line search was started since the last step then the optimizer
+    // stopped before searching, either on the iteration limit or on the
+    // stress or gradient at that step. Otherwise a line search that failed
+    // leaves the coordinates where they were, while one that succeeded but
+    // improved the stress by too little to continue moves them
+    template<typename OptimizerType, typename FunctionType, typename MatType>
+    void EndOptimization(
+      OptimizerType& optimizer,
+      FunctionType& function,
+      MatType& coordinates
+    ){
+
+      if (trials == 0) {
+        if (optimizer.MaxIterations() > 0 && iterations == optimizer.MaxIterations()) {
+          termination = "max_iterations";
+        } else if (!std::isfinite(step_stress)) {
+          termination = "non_finite_stress";
+        } else {
+          termination = "gradient_norm";
+        }
+      } else if (arma::approx_equal(coordinates, step_coords, "absdiff", 0)) {
+        termination = "line_search_failed";
+        line_search_failures += trials;
+      } else {
+        termination = "function_tolerance";
+        line_search_failures += trials - 1;
+      }
+
+    }
+
+};
+
+#endif
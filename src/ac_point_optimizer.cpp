@@ -0,0 +1,146 @@
+#include <RcppArmadillo.h>
+#include <RcppEnsmallen.h>
+#include "ac_stress.h"
+#include "ac_optimizer_options.h"
+#include "ac_point_optimizer.h"
+
+// Constructor
+AcPointOptimizer::AcPointOptimizer(
+  const arma::mat &partner_coords_in,
+  const arma::vec &table_dists_in,
+  const arma::ivec &titer_types,
+  const arma::vec &weights_in,
+  const double &dilution_stepsize
+)
+  :dilution_stepsize(dilution_stepsize)
+{
+
+  // Keep the partners with measurable then less than titers, skipping any
+  // without coordinates
+  arma::uvec finite_partners = arma::find_finite(arma::sum(partner_coords_in, 1));
+  arma::uvec finite_mask(titer_types.n_elem, arma::fill::zeros);
+  finite_mask.elem(finite_partners).ones();
+  arma::uvec measurable = arma::find(titer_types == 1 && finite_mask == 1);
+  arma::uvec lessthan = arma::find(titer_types == 2 && finite_mask == 1);
+  arma::uvec partners = arma::join_cols(measurable, lessthan);
+  num_measurable = measurable.n_elem;
+
+  partner_coords = partner_coords_in.rows(partners).t();
+  table_dists = table_dists_in.elem(partners);
+  if (weights_in.n_elem == 0) weights.ones(partners.n_elem);
+  else weights = weights_in.elem(partners);
+
+  map_dists.set_size(partners.n_elem);
+  ibases.set_size(partners.n_elem);
+
+}
+
+// Stress and inc_base for all the partners
+double AcPointOptimizer::update_stress(
+  const arma::mat &coords
+) {
+
+  arma::uword num_partners = partner_coords.n_cols;
+  for (arma::uword k = 0; k < num_partners; k++) {
+    double dist = 0;
+    for (arma::uword i = 0; i < coords.n_elem; i++) {
+      double diff = coords.at(i) - partner_coords.at(i, k);
+      dist += diff*diff;
+    }
+    map_dists(k) = std::sqrt(dist);
+  }
+
+  stress = ac_measurable_stress_block(
+    map_dists.memptr(),
+    table_dists.memptr(),
+    weights.memptr(),
+    ibases.memptr(),
+    num_measurable
+  );
+  stress += ac_lessthan_stress_block(
+    map_dists.memptr() + num_measurable,
+    table_dists.memptr() + num_measurable,
+    weights.memptr() + num_measurable,
+    ibases.memptr() + num_measurable,
+    num_partners - num_measurable,
+    dilution_stepsize
+  );
+
+  return stress;
+
+}
+
+// Evaluate the stress
+double AcPointOptimizer::Evaluate(
+  const arma::mat &coords
+) {
+  return update_stress(coords);
+}
+
+// Evaluate the stress and gradient together
+double AcPointOptimizer::EvaluateWithGradient(
+  const arma::mat &coords,
+  arma::mat &gradient
+) {
+
+  update_stress(coords);
+  gradient.zeros(coords.n_rows, coords.n_cols);
+  for (arma::uword k = 0; k < partner_coords.n_cols; k++) {
+    for (arma::uword i = 0; i < coords.n_elem; i++) {
+      gradient.at(i) -= ibases(k)*(coords.at(i) - partner_coords.at(i, k));
+    }
+  }
+  return stress;
+
+}
+
+// Relax the coordinates of a single point from the given starting coordinates
+double ac_relax_point(
+    arma::rowvec &coords,
+    AcPointOptimizer &point,
+    const AcOptimizerOptions &options
+){
+
+  ens::L_BFGS lbfgs(
+    options.num_basis,
+    options.maxit,
+    options.armijo_constant,
+    options.wolfe,
+    options.min_gradient_norm,
+    options.factr,
+    options.max_line_search_trials,
+    options.min_step,
+    options.max_step
+  );
+
+  arma::mat pars = coords.t();
+  lbfgs.Optimize(point, pars);
+  coords = pars.t();
+  return point.Evaluate(pars);
+
+}
+
+
+// Relax the coordinates of a single antigen against sera fixed in place,
+// returning the relaxed coordinates
+// [[Rcpp::export]]
+arma::rowvec ac_relax_ag_point(
+    arma::rowvec coords,
+    const arma::mat &sr_coords,
+    const arma::vec &table_dists,
+    const arma::ivec &titer_types,
+    const AcOptimizerOptions &options,
+    const double &dilution_stepsize
+){
+
+  AcPointOptimizer point(
+    sr_coords,
+    table_dists,
+    titer_types,
+    arma::vec(),
+    dilution_stepsize
+  );
+  ac_relax_point(coords, point, options);
+  return coords;
+
+}
@@ -0,0 +1,67 @@
+
+#include <RcppArmadillo.h>
+#include "ac_optimizer_options.h"
+
+#ifndef Racmacs__ac_point_optimizer__h
+#define Racmacs__ac_point_optimizer__h
+
+// An ensmallen function for the stress of a single point against points that
+// are fixed in place. Only the row or column of the titer table for the point
+// is used, so each evaluation scales with the number of titers the point has
+// rather than with the size of the whole table
+class AcPointOptimizer {
+
+  private:
+
+    // Partner coordinates are stored one per column, measurable titers first
+    // followed by less than titers, other titers contribute nothing
+    arma::mat partner_coords;
+    arma::vec table_dists;
+    arma::vec weights;
+    arma::uword num_measurable;
+    double dilution_stepsize;
+
+    // Working space for the stress blocks
+    arma::vec map_dists;
+    arma::vec ibases;
+
+    // Stress and inc_base for all the partners
+    double update_stress(
+      const arma::mat &coords
+    );
+
+  public:
+
+    double stress = arma::datum::nan;
+
+    // Constructor
+    AcPointOptimizer(
+      const arma::mat &partner_coords,
+      const arma::vec &table_dists,
+      const arma::ivec &titer_types,
+      const arma::vec &weights = arma::vec(),
+      const double &dilution_stepsize = 1.0
+    );
+
+    // Evaluate the stress
+    double Evaluate(
+      const arma::mat &coords
+    );
+
+    // Evaluate the stress and gradient together
+    double EvaluateWithGradient(
+      const arma::mat &coords,
+      arma::mat &gradient
+    );
+
+};
+
+// Relax the coordinates of a single point from the given starting coordinates,
+// returning the stress of the point
+double ac_relax_point(
+    arma::rowvec &coords,
+    AcPointOptimizer &point,
+    const AcOptimizerOptions &options
+);
+
+#endif
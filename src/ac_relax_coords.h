@@ -1,6 +1,9 @@
 
 # include <RcppArmadillo.h>
 # include "ac_optimizer_options.h"
+# include "ac_stress_problem.h"
+# include "ac_optimizer_race.h"
+# include "ac_optimizer_telemetry.h"
 
 #ifndef Racmacs__ac_relax_coords__h
 #define Racmacs__ac_relax_coords__h
@@ -17,4 +20,15 @@ double ac_relax_coords(
     const double &dilution_stepsize = 1.0
 );
 
+double ac_relax_coords(
+    const AcStressProblem &problem,
+    arma::mat &ag_coords,
+    arma::mat &sr_coords,
+    const AcOptimizerOptions &options,
+    const arma::uvec &fixed_antigens = arma::uvec(),
+    const arma::uvec &fixed_sera = arma::uvec(),
+    AcRaceCallback *race = nullptr,
+    AcOptimizerTelemetry *telemetry = nullptr
+);
+
 #endif
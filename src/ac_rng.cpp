@@ -0,0 +1,12 @@
+
+#include <RcppArmadillo.h>
+#include "ac_rng.h"
+
+// Draw a base seed from R's random number generator
+uint64_t ac_rng_seed(){
+
+  uint64_t high = static_cast<uint64_t>(R::runif(0, 4294967296.0));
+  uint64_t low = static_cast<uint64_t>(R::runif(0, 4294967296.0));
+  return (high << 32) | low;
+
+}
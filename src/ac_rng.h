@@ -0,0 +1,144 @@
+
+#include <RcppArmadillo.h>
+#include <cstdint>
+#include <cstring>
+
+#ifndef Racmacs__ac_rng__h
+#define Racmacs__ac_rng__h
+
+// Draw a base seed from R's random number generator, so that results still
+// follow set.seed()
+uint64_t ac_rng_seed();
+
+// The splitmix64 finaliser, used for hashing and random number generation
+inline uint64_t ac_mix64(
+    uint64_t z
+){
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+// Combine values into a 64 bit hash
+inline uint64_t ac_hash(
+    const uint64_t &hash,
+    const uint64_t &value
+){
+  return ac_mix64(hash ^ (value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2)));
+}
+
+inline uint64_t ac_hash(
+    const uint64_t &hash,
+    const double &value
+){
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return ac_hash(hash, bits);
+}
+
+inline uint64_t ac_hash(
+    uint64_t hash,
+    const std::string &value
+){
+  hash = ac_hash(hash, static_cast<uint64_t>(value.size()));
+  for (const char &c : value) hash = ac_hash(hash, static_cast<uint64_t>(c));
+  return hash;
+}
+
+template <typename T>
+inline uint64_t ac_hash(
+    uint64_t hash,
+    const arma::Mat<T> &values
+){
+  hash = ac_hash(hash, static_cast<uint64_t>(values.n_rows));
+  hash = ac_hash(hash, static_cast<uint64_t>(values.n_cols));
+  for (arma::uword i=0; i<values.n_elem; i++) {
+    hash = ac_hash(hash, static_cast<double>(values(i)));
+  }
+  return hash;
+}
+
+// A counter-based random number generator, each draw is a hash of a key made
+// from the seed and stream number together with a counter. Every optimization
+// run or bootstrap repeat gets its own stream, numbered by its index, so its
+// random numbers depend only on the seed and that index. This means they can
+// be generated in parallel and any one of them regenerated on its own
+class AcRng {
+
+  private:
+
+    uint64_t key;
+    uint64_t counter = 0;
+    bool has_spare_normal = false;
+    double spare_normal;
+
+  public:
+
+    // Constructor
+    AcRng(
+      const uint64_t &seed,
+      const uint64_t &stream
+    )
+      :key(ac_mix64(ac_mix64(seed) ^ ac_mix64(stream + 0x9e3779b97f4a7c15ULL)))
+    {}
+
+    // Next 64 random bits
+    inline uint64_t next(){
+      counter++;
+      return ac_mix64(key + counter*0x9e3779b97f4a7c15ULL);
+    }
+
+    // Uniform on the open interval (0, 1)
+    inline double randu(){
+      return ((next() >> 11) + 0.5) / 9007199254740992.0;
+    }
+
+    // Standard normal, by the Box-Muller transform
+    inline double randn(){
+      if (has_spare_normal) {
+        has_spare_normal = false;
+        return spare_normal;
+      }
+      double r = std::sqrt(-2.0*std::log(randu()));
+      double theta = 2.0*arma::datum::pi*randu();
+      spare_normal = r*std::sin(theta);
+      has_spare_normal = true;
+      return r*std::cos(theta);
+    }
+
+    // Gamma with shape 1 and scale 1, i.e. standard exponential
+    inline double randg(){
+      return -std::log(randu());
+    }
+
+    // Uniform integer from 0 to n - 1
+    inline arma::uword randi(
+      const arma::uword &n
+    ){
+      return static_cast<arma::uword>(randu()*n);
+    }
+
+    // Matrices and vectors filled column by column
+    template <typename T>
+    T randu(
+      const arma::uword &n_rows,
+      const arma::uword &n_cols = 1
+    ){
+      T out(n_rows, n_cols);
+      for (arma::uword i=0; i<out.n_elem; i++) out(i) = randu();
+      return out;
+    }
+
+    template <typename T>
+    T randn(
+      const arma::uword &n_rows,
+      const arma::uword &n_cols = 1
+    ){
+      T out(n_rows, n_cols);
+      for (arma::uword i=0; i<out.n_elem; i++) out(i) = randn();
+      return out;
+    }
+
+};
+
+#endif
@@ -2,25 +2,26 @@
 #include <RcppArmadillo.h>
 
 // The threshold penalty function
-double sigmoid(double &x){
+double sigmoid(const double &x){
 
   return(1/(1+exp(-10*x)));
 
 }
 
 // The derivative of the threshold penalty function
-double d_sigmoid(double &x){
+double d_sigmoid(const double &x){
 
-  return(sigmoid(x)*(1-sigmoid(x)));
+  double s = sigmoid(x);
+  return(s*(1-s));
 
 }
 
 // This is the point stress function
 double ac_ptStress(
-    double &map_dist,
-    double &table_dist,
-    arma::sword &titer_type,
-    double &dilution_stepsize
+    const double &map_dist,
+    const double &table_dist,
+    const arma::sword &titer_type,
+    const double &dilution_stepsize
   ){
 
   double x;
@@ -52,10 +53,10 @@ double ac_ptStress(
 
 // This is the point residual function
 double ac_ptResidual(
-    double &map_dist,
-    double &table_dist,
-    arma::sword &titer_type,
-    double &dilution_stepsize
+    const double &map_dist,
+    const double &table_dist,
+    const arma::sword &titer_type,
+    const double &dilution_stepsize
 ){
 
   double x;
@@ -88,16 +89,18 @@ double ac_ptResidual(
 
 // This is for calculating the inc_base part of the stress gradient function
 double inc_base(
-    double &map_dist,
-    double &table_dist,
-    arma::sword &titer_type,
-    double &dilution_stepsize
+    const double &map_dist_in,
+    const double &table_dist,
+    const arma::sword &titer_type,
+    const double &dilution_stepsize
   ){
 
   double ibase;
   double x;
+  double s;
 
   // Deal with 0 map distance
+  double map_dist = map_dist_in;
   if (map_dist == 0) {
     map_dist = 1e-5;
   }
@@ -110,7 +113,8 @@ double inc_base(
   case 2:
     // Less than titer
     x = table_dist - map_dist + dilution_stepsize;
-    ibase = (10*x*x*d_sigmoid(x) + 2*x*sigmoid(x)) / map_dist;
+    s = sigmoid(x);
+    ibase = (10*x*x*s*(1-s) + 2*x*s) / map_dist;
     break;
   case 3:
     // More than titer
@@ -127,3 +131,65 @@ double inc_base(
 }
 
 
+// Stress and inc_base for a block of measurable titers, the block is
+// processed without branching on titer type so that the loop vectorises
+double ac_measurable_stress_block(
+    const double *map_dists,
+    const double *table_dists,
+    const double *weights,
+    double *ibases,
+    const arma::uword &n
+){
+
+  double stress = 0;
+
+  #pragma omp simd reduction(+:stress)
+  for (arma::uword i = 0; i < n; i++) {
+
+    // Deal with 0 map distance, only where the gradient divides by it, the
+    // gradient term is multiplied by the coordinate differences so is 0
+    // for these anyway
+    double x = table_dists[i] - map_dists[i];
+    double grad_map_dist = map_dists[i] == 0 ? 1e-5 : map_dists[i];
+
+    stress += weights[i] * x * x;
+    ibases[i] = weights[i] * ((2*x) / grad_map_dist);
+
+  }
+
+  return stress;
+
+}
+
+
+// Stress and inc_base for a block of less than titers, the sigmoid is only
+// evaluated once per titer and shared between the stress and its derivative
+double ac_lessthan_stress_block(
+    const double *map_dists,
+    const double *table_dists,
+    const double *weights,
+    double *ibases,
+    const arma::uword &n,
+    const double &dilution_stepsize
+){
+
+  double stress = 0;
+
+  #pragma omp simd reduction(+:stress)
+  for (arma::uword i = 0; i < n; i++) {
+
+    // Deal with 0 map distance, only where the gradient divides by it, the
+    // gradient term is multiplied by the coordinate differences so is 0
+    // for these anyway
+    double x = table_dists[i] - map_dists[i] + dilution_stepsize;
+    double s = 1/(1+exp(-10*x));
+    double grad_map_dist = map_dists[i] == 0 ? 1e-5 : map_dists[i];
+
+    stress += weights[i] * x * x * s;
+    ibases[i] = weights[i] * ((10*x*x*s*(1-s) + 2*x*s) / grad_map_dist);
+
+  }
+
+  return stress;
+
+}
@@ -5,33 +5,52 @@
 #define Racmacs__ac_stress__h
 
 // The threshold penalty function
-double sigmoid(double &x);
+double sigmoid(const double &x);
 
 // The derivative of the threshold penalty function
-double d_sigmoid(double &x);
+double d_sigmoid(const double &x);
 
 // This is the point stress function
 double ac_ptStress(
-  double &map_dist,
-  double &table_dist,
-  arma::sword &titer_type,
-  double &dilution_stepsize
+  const double &map_dist,
+  const double &table_dist,
+  const arma::sword &titer_type,
+  const double &dilution_stepsize
 );
 
 // This is the point residual function
 double ac_ptResidual(
-    double &map_dist,
-    double &table_dist,
-    arma::sword &titer_type,
-    double &dilution_stepsize
+    const double &map_dist,
+    const double &table_dist,
+    const arma::sword &titer_type,
+    const double &dilution_stepsize
 );
 
 // This is the inc_base function used in the stress gradient function
 double inc_base(
-  double &map_dist,
-  double &table_dist,
-  arma::sword &titer_type,
-  double &dilution_stepsize
+  const double &map_dist,
+  const double &table_dist,
+  const arma::sword &titer_type,
+  const double &dilution_stepsize
+);
+
+// Batch stress and inc_base for a block of measurable titers
+double ac_measurable_stress_block(
+  const double *map_dists,
+  const double *table_dists,
+  const double *weights,
+  double *ibases,
+  const arma::uword &n
+);
+
+// Batch stress and inc_base for a block of less than titers
+double ac_lessthan_stress_block(
+  const double *map_dists,
+  const double *table_dists,
+  const double *weights,
+  double *ibases,
+  const arma::uword &n,
+  const double &dilution_stepsize
 );
 
 #endif
@@ -0,0 +1,52 @@
+
+#include <RcppArmadillo.h>
+#include "ac_stress_problem.h"
+
+// Constructor
+AcStressProblem::AcStressProblem(
+  const arma::mat &tabledist,
+  const arma::imat &titertype,
+  const arma::mat &titer_weights_in,
+  const double &dilution_stepsize
+)
+  :tabledist_matrix(tabledist),
+   titertype_matrix(titertype),
+   dilution_stepsize(dilution_stepsize),
+   num_ags(tabledist.n_rows),
+   num_sr(tabledist.n_cols)
+{
+
+  // Set default weights to 1 if missing
+  if (titer_weights_in.n_elem == 0) titer_weights.ones(num_ags, num_sr);
+  else                              titer_weights = titer_weights_in;
+
+  // Index the measured pairs, grouped by titer type
+  add_measured_pairs(1);
+  num_measurable = measured_pairs.size();
+  add_measured_pairs(2);
+
+}
+
+// Add measured pairs of a given titer type to the index
+void AcStressProblem::add_measured_pairs(
+  const arma::sword &titer_type
+) {
+
+  for(arma::uword sr = 0; sr < num_sr; ++sr) {
+    for(arma::uword ag = 0; ag < num_ags; ++ag) {
+
+      // Skip titers of other types
+      if(titertype_matrix.at(ag, sr) != titer_type) continue;
+
+      measured_pairs.push_back(MeasuredPair{
+        ag,
+        sr,
+        titer_type,
+        tabledist_matrix.at(ag, sr),
+        titer_weights.at(ag, sr)
+      });
+
+    }
+  }
+
+}
@@ -0,0 +1,52 @@
+
+#include <RcppArmadillo.h>
+
+#ifndef Racmacs__ac_stress_problem__h
+#define Racmacs__ac_stress_problem__h
+
+// A measured antigen-serum pair, stored so that the stress and gradient
+// passes only need to visit titrated pairs
+struct MeasuredPair {
+  arma::uword ag;
+  arma::uword sr;
+  arma::sword titer_type;
+  double table_dist;
+  double weight;
+};
+
+// The read only table data needed to calculate map stress. This is built once
+// and then shared by reference between every optimization run relaxed against
+// the same table, so runs only need to hold their own coordinates and gradients
+class AcStressProblem {
+
+  public:
+
+    arma::mat tabledist_matrix;
+    arma::imat titertype_matrix;
+    arma::mat titer_weights;
+    double dilution_stepsize;
+    arma::uword num_ags;
+    arma::uword num_sr;
+
+    // Measurable titers are stored first followed by less than titers, more
+    // than titers contribute nothing to the stress so are left out
+    std::vector<MeasuredPair> measured_pairs;
+    arma::uword num_measurable;
+
+    // Constructor
+    explicit AcStressProblem(
+      const arma::mat &tabledist,
+      const arma::imat &titertype,
+      const arma::mat &titer_weights_in = arma::mat(),
+      const double &dilution_stepsize = 1.0
+    );
+
+  private:
+
+    void add_measured_pairs(
+      const arma::sword &titer_type
+    );
+
+};
+
+#endif
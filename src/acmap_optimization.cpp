@@ -8,6 +8,10 @@
 #include "acmap_titers.h"
 #include "acmap_diagnostics.h"
 #include "ac_optimizer_options.h"
+#include "ac_stress_problem.h"
+#include "ac_optimizer_race.h"
+#include "ac_optimizer_telemetry.h"
+#include "ac_rng.h"
 #include "ac_relax_coords.h"
 #include "ac_coords_stress.h"
 #include "ac_bootstrap_output.h"
@@ -444,13 +448,14 @@ void AcOptimization::reduceDimensions(
 
 // Randomise coordinates
 void AcOptimization::randomizeCoords(
-    double boxsize
+    double boxsize,
+    AcRng &rng
 ) {
 
   double min = -boxsize/2.0;
   double max = boxsize/2.0;
-  ag_base_coords.randu();
-  sr_base_coords.randu();
+  ag_base_coords = rng.randu<arma::mat>(ag_base_coords.n_rows, ag_base_coords.n_cols);
+  sr_base_coords = rng.randu<arma::mat>(sr_base_coords.n_rows, sr_base_coords.n_cols);
   ag_base_coords = ag_base_coords*(max-min) + min;
   sr_base_coords = sr_base_coords*(max-min) + min;
   invalidate_stress();
@@ -483,16 +488,37 @@ void AcOptimization::relax_from_raw_matrices(
     const double &dilution_stepsize
 ) {
 
+  relax_from_stress_problem(
+    AcStressProblem(
+      tabledist_matrix,
+      titertype_matrix,
+      titer_weights,
+      dilution_stepsize
+    ),
+    options,
+    fixed_antigens,
+    fixed_sera
+  );
+
+}
+
+void AcOptimization::relax_from_stress_problem(
+    const AcStressProblem &problem,
+    const AcOptimizerOptions options,
+    const arma::uvec &fixed_antigens,
+    const arma::uvec &fixed_sera,
+    AcRaceCallback *race
+) {
+
   stress = ac_relax_coords(
-    tabledist_matrix,
-    titertype_matrix,
+    problem,
     ag_base_coords,
     sr_base_coords,
     options,
     fixed_antigens,
     fixed_sera,
-    titer_weights,
-    dilution_stepsize
+    race,
+    &telemetry
   );
 
 }
@@ -8,6 +8,10 @@
 #include "acmap_titers.h"
 #include "acmap_diagnostics.h"
 #include "ac_optimizer_options.h"
+#include "ac_stress_problem.h"
+#include "ac_optimizer_race.h"
+#include "ac_optimizer_telemetry.h"
+#include "ac_rng.h"
 #include "ac_relax_coords.h"
 #include "ac_coords_stress.h"
 #include "ac_bootstrap_output.h"
@@ -34,6 +38,7 @@ class AcOptimization {
     std::vector<AcDiagnostics> ag_diagnostics;
     std::vector<AcDiagnostics> sr_diagnostics;
     std::vector<BootstrapOutput> bootstrap;
+    AcOptimizerTelemetry telemetry;
     double stress = arma::datum::nan;
 
     // Constructors
@@ -189,7 +194,8 @@ class AcOptimization {
 
     // Randomise coordinates
     void randomizeCoords(
-      double boxsize
+      double boxsize,
+      AcRng &rng
     );
 
     // Get table distances
@@ -208,6 +214,14 @@ class AcOptimization {
       const double &dilution_stepsize = 1.0
     );
 
+    void relax_from_stress_problem(
+      const AcStressProblem &problem,
+      const AcOptimizerOptions options,
+      const arma::uvec &fixed_antigens = arma::uvec(),
+      const arma::uvec &fixed_sera = arma::uvec(),
+      AcRaceCallback *race = nullptr
+    );
+
     void relax_from_titer_table(
       AcTiterTable titers,
       const AcOptimizerOptions options,
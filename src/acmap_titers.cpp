@@ -2,6 +2,13 @@
 #include <RcppArmadillo.h>
 #include "acmap_titers.h"
 #include "utils_error.h"
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <list>
+#include <stdexcept>
 
 // AcTiter
 AcTiter::AcTiter(){
@@ -24,22 +31,38 @@ AcTiter::AcTiter(
   type = 1;
 }
 
+// Parse the numeric part of a titer in place, with the same errors as
+// std::stod but without copying the string
+static double parse_titer_number(
+    const char *titer
+){
+
+  char *end;
+  errno = 0;
+  double numeric = std::strtod(titer, &end);
+  if(end == titer) throw std::invalid_argument("stod");
+  if(errno == ERANGE) throw std::out_of_range("stod");
+  return numeric;
+
+}
+
 AcTiter::AcTiter(
-  std::string titer
+  const char *titer
 ){
 
-  switch(titer.at(0)){
+  switch(titer[0]){
+  case '\0':
+    // Empty titer
+    throw std::out_of_range("Empty titer");
   case '<':
     // Less than titer
-    titer.erase(0,1);
     type = 2;
-    numeric = std::stod(titer);
+    numeric = parse_titer_number(titer + 1);
     break;
   case '>':
     // Greater than titer
-    titer.erase(0,1);
     type = 3;
-    numeric = std::stod(titer);
+    numeric = parse_titer_number(titer + 1);
     break;
   case '*':
     // Unmeasured or ignored titer
@@ -54,43 +77,75 @@ AcTiter::AcTiter(
   default:
     // Measurable titer
     type = 1;
-    numeric = std::stod(titer);
+    numeric = parse_titer_number(titer);
   }
 
 }
 
-// Conversion back to a string
-std::string AcTiter::toString() const {
-
-  // Get the titer as a string
-  std::ostringstream ss;
-  ss << numeric;
-  std::string titer = ss.str();
+AcTiter::AcTiter(
+  const std::string &titer
+):AcTiter(titer.c_str()){}
+
+// Strings for the standard dilution series 10, 20, 40 ... 327680, which
+// cover almost all titers, so they can be looked up rather than formatted
+static const char* dilution_series_strings[] = {
+  "10", "20", "40", "80", "160", "320", "640", "1280", "2560", "5120",
+  "10240", "20480", "40960", "81920", "163840", "327680"
+};
+
+// Conversion back to a string written into a buffer
+int AcTiter::format(
+    char *buffer
+) const {
 
-  // Append lessthan signs etc depending on type
+  // Add lessthan signs etc depending on type
+  int length = 0;
   switch(type) {
   case 0:
     // Unmeasured titer
-    titer = "*";
-    break;
+    buffer[0] = '*';
+    buffer[1] = '\0';
+    return 1;
   case 1:
     // Measurable titer
     break;
   case 2:
     // Less than titer
-    titer = "<"+titer;
+    buffer[length++] = '<';
     break;
   case 3:
     // More than titer
-    titer = ">"+titer;
+    buffer[length++] = '>';
     break;
   default:
     // Omitted titer
-    titer = ".";
+    buffer[0] = '.';
+    buffer[1] = '\0';
+    return 1;
+  }
+
+  // Look up titers in the standard dilution series, otherwise format them
+  // the same way as the default for an output stream
+  int exponent;
+  if(
+    std::frexp(numeric / 10.0, &exponent) == 0.5 &&
+    exponent >= 1 && exponent <= 16
+  ){
+    const char *dilution = dilution_series_strings[exponent - 1];
+    std::size_t dilution_length = std::strlen(dilution);
+    std::memcpy(buffer + length, dilution, dilution_length + 1);
+    return length + dilution_length;
   }
+  return length + std::snprintf(buffer + length, string_buffer_size - length, "%g", numeric);
+
+}
+
+// Conversion back to a string
+std::string AcTiter::toString() const {
 
-  // Return the titer
-  return titer;
+  char buffer[string_buffer_size];
+  int length = format(buffer);
+  return std::string(buffer, length);
 
 }
 
@@ -119,6 +174,95 @@ void AcTiter::roundTiter() {
 }
 
 
+// Check if a numeric titer can be held exactly in single precision
+static bool single_precision_exact(
+    const double &numeric_titer
+){
+  return std::isnan(numeric_titer) || (double)(float)numeric_titer == numeric_titer;
+}
+
+// Check if two matrices hold exactly the same values, including any NA values
+template <typename T>
+static bool same_values(
+    const arma::Mat<T> &a,
+    const arma::Mat<T> &b
+){
+  return a.n_rows == b.n_rows && a.n_cols == b.n_cols && (
+    a.n_elem == 0 || std::memcmp(a.memptr(), b.memptr(), a.n_elem*sizeof(T)) == 0
+  );
+}
+
+// Column bases and table distances recently calculated, along with the titers
+// and arguments they were calculated from. Titer tables are converted afresh
+// from R on every call, so this is kept for the whole session rather than on
+// each table, and is matched on the titers themselves, which is much quicker
+// than the log transforms it saves. Changing a titer gives a different table
+// so nothing needs to be invalidated. Only the most recently used tables are
+// kept, up to a limit on the total number of titers
+struct AcTableDistanceCacheEntry {
+  AcTiterTable titers;
+  std::string min_colbasis;
+  arma::vec fixed_colbases;
+  arma::vec ag_reactivity_adjustments;
+  arma::vec colbases;
+  arma::mat dists;
+};
+
+static std::list<AcTableDistanceCacheEntry> table_distance_cache;
+static const arma::uword table_distance_cache_max_titers = 1 << 24;
+
+// Find a cache entry for the titers and arguments given, moving it to the
+// front as the most recently used, must be called from within the
+// ac_table_distance_cache critical section
+static AcTableDistanceCacheEntry* find_table_distance_cache_entry(
+    const AcTiterTable &titers,
+    const std::string &min_colbasis,
+    const arma::vec &fixed_colbases,
+    const arma::vec &ag_reactivity_adjustments
+){
+
+  for (auto entry = table_distance_cache.begin(); entry != table_distance_cache.end(); ++entry) {
+    if (
+      entry->min_colbasis == min_colbasis &&
+      same_values(entry->fixed_colbases, fixed_colbases) &&
+      same_values(entry->ag_reactivity_adjustments, ag_reactivity_adjustments) &&
+      entry->titers.same_titers(titers)
+    ) {
+      table_distance_cache.splice(table_distance_cache.begin(), table_distance_cache, entry);
+      return &table_distance_cache.front();
+    }
+  }
+  return nullptr;
+
+}
+
+// Add a cache entry, dropping the least recently used entries to make room
+static void add_table_distance_cache_entry(
+    const AcTableDistanceCacheEntry &entry
+){
+
+  arma::uword num_titers = entry.titers.nags()*entry.titers.nsr();
+  if (num_titers > table_distance_cache_max_titers) return;
+
+  #pragma omp critical(ac_table_distance_cache)
+  {
+    if (!find_table_distance_cache_entry(
+      entry.titers,
+      entry.min_colbasis,
+      entry.fixed_colbases,
+      entry.ag_reactivity_adjustments
+    )) {
+      for (auto &cached : table_distance_cache) num_titers += cached.titers.nags()*cached.titers.nsr();
+      while (num_titers > table_distance_cache_max_titers) {
+        num_titers -= table_distance_cache.back().titers.nags()*table_distance_cache.back().titers.nsr();
+        table_distance_cache.pop_back();
+      }
+      table_distance_cache.push_front(entry);
+    }
+  }
+
+}
+
 // AcTiterTable
 AcTiterTable::AcTiterTable(
   int nags,
@@ -128,16 +272,72 @@ numeric_titers(nags, nsr, arma::fill::zeros),
 titer_types(nags, nsr, arma::fill::zeros){};
 
 // Get dimensions
-arma::uword AcTiterTable::nags() const { return numeric_titers.n_rows; }
-arma::uword AcTiterTable::nsr() const { return numeric_titers.n_cols; }
-arma::SizeMat AcTiterTable::size() const { return arma::size(numeric_titers); }
+arma::uword AcTiterTable::nags() const { return titer_types.n_rows; }
+arma::uword AcTiterTable::nsr() const { return titer_types.n_cols; }
+arma::SizeMat AcTiterTable::size() const { return arma::size(titer_types); }
 
 // Get and set numeric_titers and titer types
-arma::mat AcTiterTable::get_numeric_titers() const { return numeric_titers; }
-void AcTiterTable::set_numeric_titers(arma::mat numeric_titers_in){ numeric_titers = numeric_titers_in; }
+arma::mat AcTiterTable::get_numeric_titers() const {
+  if (exact_titers) return numeric_titers_exact;
+  return arma::conv_to<arma::mat>::from(numeric_titers);
+}
+
+void AcTiterTable::set_numeric_titers(arma::mat numeric_titers_in){
 
-arma::imat AcTiterTable::get_titer_types() const { return titer_types; }
-void AcTiterTable::set_titer_types(arma::imat titer_types_in){ titer_types = titer_types_in; }
+  // Use single precision storage if it holds every titer exactly
+  exact_titers = !numeric_titers_in.is_empty() && !std::all_of(
+    numeric_titers_in.begin(),
+    numeric_titers_in.end(),
+    single_precision_exact
+  );
+
+  if (exact_titers) {
+    numeric_titers_exact = numeric_titers_in;
+    numeric_titers.reset();
+  } else {
+    numeric_titers = arma::conv_to<arma::fmat>::from(numeric_titers_in);
+    numeric_titers_exact.reset();
+  }
+
+}
+
+arma::imat AcTiterTable::get_titer_types() const {
+  return arma::conv_to<arma::imat>::from(titer_types);
+}
+
+void AcTiterTable::set_titer_types(arma::imat titer_types_in){
+  titer_types = arma::conv_to< arma::Mat<arma::s8> >::from(titer_types_in);
+}
+
+// Get and set a single numeric titer from whichever storage is in use
+double AcTiterTable::get_numeric_titer(
+    const arma::uword &agnum,
+    const arma::uword &srnum
+) const {
+
+  if (exact_titers) return numeric_titers_exact(agnum, srnum);
+  return numeric_titers(agnum, srnum);
+
+}
+
+void AcTiterTable::set_numeric_titer(
+    const arma::uword &agnum,
+    const arma::uword &srnum,
+    const double &numeric_titer
+){
+
+  // Switch to double precision storage the first time a titer is set that
+  // single precision cannot hold exactly
+  if (!exact_titers && !single_precision_exact(numeric_titer)) {
+    numeric_titers_exact = arma::conv_to<arma::mat>::from(numeric_titers);
+    numeric_titers.reset();
+    exact_titers = true;
+  }
+
+  if (exact_titers) numeric_titers_exact(agnum, srnum) = numeric_titer;
+  else              numeric_titers(agnum, srnum) = numeric_titer;
+
+}
 
 // Get a given titer
 AcTiter AcTiterTable::get_titer(
@@ -146,7 +346,7 @@ AcTiter AcTiterTable::get_titer(
 ) const {
 
   return AcTiter(
-    numeric_titers(agnum, srnum),
+    get_numeric_titer(agnum, srnum),
     titer_types(agnum, srnum)
   );
 
@@ -165,7 +365,7 @@ void AcTiterTable::set_titer(
   }
 
   // Set the titer
-  numeric_titers(agnum, srnum) = titer.numeric;
+  set_numeric_titer(agnum, srnum, titer.numeric);
   titer_types(agnum, srnum) = titer.type;
 
 }
@@ -187,7 +387,7 @@ void AcTiterTable::set_titer_string(
     std::string titerstring
 ){
 
-  AcTiter titer = AcTiter(titerstring);
+  AcTiter titer = AcTiter(titerstring.c_str());
   set_titer(agnum, srnum, titer);
 
 }
@@ -233,7 +433,7 @@ std::vector<AcTiter> AcTiterTable::srTiters(
 void AcTiterTable::remove_antigen(
     arma::uword agnum
 ){
-  numeric_titers.shed_row(agnum);
+  update_numeric_titers([&](auto &titers){ titers.shed_row(agnum); });
   titer_types.shed_row(agnum);
 }
 
@@ -241,7 +441,7 @@ void AcTiterTable::remove_antigen(
 void AcTiterTable::remove_serum(
     arma::uword srnum
 ){
-  numeric_titers.shed_col(srnum);
+  update_numeric_titers([&](auto &titers){ titers.shed_col(srnum); });
   titer_types.shed_col(srnum);
 }
 
@@ -250,7 +450,7 @@ void AcTiterTable::subset_antigens(
     arma::uvec ags
 ){
 
-  numeric_titers = numeric_titers.rows(ags);
+  update_numeric_titers([&](auto &titers){ titers = titers.rows(ags); });
   titer_types = titer_types.rows(ags);
 
 }
@@ -259,7 +459,7 @@ void AcTiterTable::subset_sera(
     arma::uvec sr
 ){
 
-  numeric_titers = numeric_titers.cols(sr);
+  update_numeric_titers([&](auto &titers){ titers = titers.cols(sr); });
   titer_types = titer_types.cols(sr);
 
 }
@@ -269,7 +469,7 @@ void AcTiterTable::subset(
     arma::uvec sr
 ){
 
-  numeric_titers = numeric_titers.submat(ags, sr);
+  update_numeric_titers([&](auto &titers){ titers = titers.submat(ags, sr); });
   titer_types = titer_types.submat(ags, sr);
 
 }
@@ -298,7 +498,7 @@ void AcTiterTable::set_unmeasured(
     arma::uvec indices
 ){
   titer_types.elem(indices).zeros();
-  numeric_titers.elem(indices).zeros();
+  update_numeric_titers([&](auto &titers){ titers.elem(indices).zeros(); });
 }
 
 // Getting indices of titers
@@ -342,8 +542,26 @@ arma::vec AcTiterTable::calc_colbases(
   }
   if(arma::accu(titer_types > 0) == 0) return fixed_colbases;
 
+  // Use cached column bases if available
+  arma::vec colbases;
+  bool cached = false;
+  #pragma omp critical(ac_table_distance_cache)
+  {
+    AcTableDistanceCacheEntry *entry = find_table_distance_cache_entry(
+      *this,
+      min_colbasis,
+      fixed_colbases,
+      ag_reactivity_adjustments
+    );
+    if (entry) {
+      colbases = entry->colbases;
+      cached = true;
+    }
+  }
+  if(cached) return colbases;
+
   // Get log titers
-  arma::mat num_titers = numeric_titers;
+  arma::mat num_titers = get_numeric_titers();
   arma::mat log_titers = arma::log2(num_titers / 10.0);
 
   // Apply antigen reactivity adjustments
@@ -351,7 +569,7 @@ arma::vec AcTiterTable::calc_colbases(
 
   // Calculate column bases
   log_titers.replace(arma::datum::nan, log_titers.min());
-  arma::vec colbases = arma::max(log_titers.t(), 1);
+  colbases = arma::max(log_titers.t(), 1);
 
   // Apply any minimum column bases
   if(min_colbasis != "none"){
@@ -388,6 +606,24 @@ arma::mat AcTiterTable::numeric_table_distances(
     const arma::vec &ag_reactivity_adjustments
 ) const {
 
+  // Use cached distances if available
+  arma::mat dists;
+  bool cached = false;
+  #pragma omp critical(ac_table_distance_cache)
+  {
+    AcTableDistanceCacheEntry *entry = find_table_distance_cache_entry(
+      *this,
+      minimum_col_basis,
+      fixed_colbases,
+      ag_reactivity_adjustments
+    );
+    if (entry) {
+      dists = entry->dists;
+      cached = true;
+    }
+  }
+  if(cached) return dists;
+
   // Calculate column bases
   arma::vec colbases = calc_colbases(
     minimum_col_basis,
@@ -396,7 +632,7 @@ arma::mat AcTiterTable::numeric_table_distances(
   );
 
   // Set distances as log titers
-  arma::mat dists = arma::log2(numeric_titers / 10.0);
+  dists = arma::log2(get_numeric_titers() / 10.0);
 
   // Apply antigen reactivity adjustments
   dists.each_col() += ag_reactivity_adjustments;
@@ -414,23 +650,87 @@ arma::mat AcTiterTable::numeric_table_distances(
   // Replace na titers with na dists
   dists.elem( arma::find(titer_types <= 0) ).fill( arma::datum::nan );
 
+  // Cache the column bases and distances
+  add_table_distance_cache_entry({
+    *this,
+    minimum_col_basis,
+    fixed_colbases,
+    ag_reactivity_adjustments,
+    colbases,
+    dists
+  });
+
   // Return distance matrix
   return dists;
 
 }
 
+// Check if another table holds exactly the same titers
+bool AcTiterTable::same_titers(
+    const AcTiterTable &titertable
+) const {
+
+  return exact_titers == titertable.exact_titers &&
+    same_values(titer_types, titertable.titer_types) &&
+    same_values(numeric_titers, titertable.numeric_titers) &&
+    same_values(numeric_titers_exact, titertable.numeric_titers_exact);
+
+}
+
 // Add log titers to the titer table
 void AcTiterTable::add_log_titers(
     arma::mat log_titers_to_add
 ){
 
-  arma::mat logtiters = arma::log2(numeric_titers / 10.0);
+  arma::mat logtiters = arma::log2(get_numeric_titers() / 10.0);
   logtiters += log_titers_to_add;
-  numeric_titers = arma::exp2(logtiters)*10.0;
+  set_numeric_titers(arma::exp2(logtiters)*10.0);
 
 }
 
 // Round the titers
 void AcTiterTable::roundTiters() {
-  numeric_titers = arma::round(numeric_titers);
+  set_numeric_titers(arma::round(get_numeric_titers()));
 }
+
+
+// AcSparseTiterTable
+AcSparseTiterTable::AcSparseTiterTable():
+num_ags(0),
+num_sr(0),
+col_starts(1, 0)
+{}
+
+AcSparseTiterTable::AcSparseTiterTable(
+  const AcTiterTable &titertable
+):
+num_ags(titertable.nags()),
+num_sr(titertable.nsr()),
+col_starts(titertable.nsr() + 1, 0)
+{
+
+  // Work down the dense storage once, keeping titers that are not "*"
+  for(arma::uword sr=0; sr<num_sr; sr++){
+    for(arma::uword ag=0; ag<num_ags; ag++){
+      int type = titertable.titer_types.at(ag, sr);
+      if(type == 0) continue;
+      ag_indices.push_back(ag);
+      titers.push_back(AcTiter(titertable.get_numeric_titer(ag, sr), type));
+    }
+    col_starts[sr + 1] = titers.size();
+  }
+
+}
+
+// Get dimensions
+arma::uword AcSparseTiterTable::nags() const { return num_ags; }
+arma::uword AcSparseTiterTable::nsr() const { return num_sr; }
+arma::uword AcSparseTiterTable::num_stored() const { return titers.size(); }
+
+// Get the range of stored titers for a serum
+arma::uword AcSparseTiterTable::col_start(const arma::uword &srnum) const { return col_starts[srnum]; }
+arma::uword AcSparseTiterTable::col_end(const arma::uword &srnum) const { return col_starts[srnum + 1]; }
+
+// Get a stored titer and the antigen it belongs to
+arma::uword AcSparseTiterTable::ag_index(const arma::uword &i) const { return ag_indices[i]; }
+const AcTiter& AcSparseTiterTable::titer(const arma::uword &i) const { return titers[i]; }
@@ -22,12 +22,23 @@ class AcTiter {
     );
 
     AcTiter(
-      std::string titer
+      const char *titer
+    );
+
+    AcTiter(
+      const std::string &titer
     );
 
     // Conversion back to a string
     std::string toString() const;
 
+    // Conversion back to a string written into a buffer of at least
+    // string_buffer_size characters, returning the length of the string
+    static const int string_buffer_size = 32;
+    int format(
+      char *buffer
+    ) const;
+
     // Conversion to log titer
     double logTiter(
         double dilution_stepsize
@@ -42,6 +53,9 @@ class AcTiter {
 // Define the titertable class
 class AcTiterTable {
 
+  // The sparse form reads the titer storage directly when it is built
+  friend class AcSparseTiterTable;
+
   private:
     // The titers are stored as a matrix of numeric forms and one of titer types
     // Types:
@@ -49,8 +63,36 @@ class AcTiterTable {
     // 1 = measured detectable e.g. "40"
     // 2 = measured lessthan e.g. "<10"
     // 3 = measured morethan e.g. ">1280"
-    arma::mat numeric_titers;
-    arma::imat titer_types;
+    //
+    // To keep large tables and their layers compact, types are stored in a
+    // single byte and numeric titers in single precision, which holds integer
+    // titers exactly only up to 2^24 (16777216). If any titer cannot be held
+    // exactly in single precision, such as a larger integer or most
+    // non-integer titers, the numeric titers are stored in double precision
+    // instead, conversion to the usual types happens only in the accessors
+    arma::fmat numeric_titers;
+    arma::mat numeric_titers_exact;
+    bool exact_titers = false;
+    arma::Mat<arma::s8> titer_types;
+
+    // Get and set a single numeric titer from whichever storage is in use
+    double get_numeric_titer(
+      const arma::uword &agnum,
+      const arma::uword &srnum
+    ) const;
+
+    void set_numeric_titer(
+      const arma::uword &agnum,
+      const arma::uword &srnum,
+      const double &numeric_titer
+    );
+
+    // Apply a function to whichever numeric titer storage is in use
+    template <typename F>
+    void update_numeric_titers(F f) {
+      if (exact_titers) f(numeric_titers_exact);
+      else              f(numeric_titers);
+    }
 
   public:
 
@@ -103,6 +145,35 @@ class AcTiterTable {
         double titerdouble
     );
 
+    // Setting all titers at once from strings, titer_string(i) should return
+    // the string for the ith titer in column major order as a C string
+    template <typename F>
+    void set_titer_strings(F titer_string) {
+      arma::mat numeric_titers_in(arma::size(titer_types));
+      for(arma::uword i=0; i<titer_types.n_elem; i++){
+        AcTiter titer(titer_string(i));
+        numeric_titers_in(i) = titer.numeric;
+        titer_types(i) = titer.type;
+      }
+      set_numeric_titers(numeric_titers_in);
+    }
+
+    // Getting all titers at once as strings, store_string(i, string, length)
+    // is called with the ith titer in column major order, the string is only
+    // valid for the duration of the call
+    template <typename F>
+    void get_titer_strings(F store_string) const {
+      char buffer[AcTiter::string_buffer_size];
+      for(arma::uword i=0; i<titer_types.n_elem; i++){
+        AcTiter titer(
+          exact_titers ? numeric_titers_exact(i) : numeric_titers(i),
+          titer_types(i)
+        );
+        int length = titer.format(buffer);
+        store_string(i, buffer, length);
+      }
+    }
+
     // Get vector of titers for a given antigen
     std::vector<AcTiter> agTiters(
       arma::uword agnum
@@ -156,7 +227,13 @@ class AcTiterTable {
     arma::uvec vec_indices_measured(
     ) const;
 
-    // Calculate column bases
+    // Check if another table holds exactly the same titers
+    bool same_titers(
+      const AcTiterTable &titertable
+    ) const;
+
+    // Calculate column bases, these and the table distances are cached for
+    // the most recently used tables, see acmap_titers.cpp
     arma::vec calc_colbases(
         const std::string &min_colbasis,
         const arma::vec &fixed_colbases,
@@ -180,6 +257,58 @@ class AcTiterTable {
 
 };
 
+
+// A sparse form of a titer table, for titer layers that cover only a small
+// part of the merged table. Only titers that are not "*" are stored, in
+// compressed columns by serum with antigens in ascending order. Columns are
+// used rather than rows by antigen since the dense tables are column major,
+// so the sparse form is built in a single pass down the storage, and since
+// layer merging is parallelised over sera, each of which then reads a
+// contiguous range of every layer
+class AcSparseTiterTable {
+
+  private:
+    arma::uword num_ags;
+    arma::uword num_sr;
+    std::vector<arma::uword> col_starts;
+    std::vector<arma::uword> ag_indices;
+    std::vector<AcTiter> titers;
+
+  public:
+
+    // Constructor for an empty table
+    AcSparseTiterTable();
+
+    // Constructor from a dense titer table
+    AcSparseTiterTable(
+      const AcTiterTable &titertable
+    );
+
+    // Get dimensions
+    arma::uword nags() const;
+    arma::uword nsr() const;
+    arma::uword num_stored() const;
+
+    // Get the range of stored titers for a serum
+    arma::uword col_start(
+      const arma::uword &srnum
+    ) const;
+
+    arma::uword col_end(
+      const arma::uword &srnum
+    ) const;
+
+    // Get a stored titer and the antigen it belongs to
+    arma::uword ag_index(
+      const arma::uword &i
+    ) const;
+
+    const AcTiter& titer(
+      const arma::uword &i
+    ) const;
+
+};
+
 #endif
 
 
@@ -28,9 +28,9 @@ void set_titers_from_json(
 
   for (SizeType ag = 0; ag < td.Size(); ag++){
     for (auto& sr : td[ag].GetObject()){
-      titer_table.set_titer_string(
+      titer_table.set_titer(
         ag, strtoimax( sr.name.GetString(), NULL, 10 ),
-        sr.value.GetString()
+        AcTiter(sr.value.GetString())
       );
     }
   }
@@ -143,14 +143,10 @@ AcMap json_to_acmap(
     if(t.HasMember("l")){
 
       // This is for the case that titers are stored simply as a matrix
-      for (int ag = 0; ag < num_antigens; ag++){
-        for (int sr = 0; sr < num_sera; sr++){
-          map.titer_table_flat.set_titer_string(
-            ag, sr,
-            t["l"][ag][sr].GetString()
-          );
-        }
-      }
+      const Value& l = t["l"];
+      map.titer_table_flat.set_titer_strings(
+        [&](arma::uword i){ return l[SizeType(i % num_antigens)][SizeType(i / num_antigens)].GetString(); }
+      );
 
     } else if (t.HasMember("d")){
 
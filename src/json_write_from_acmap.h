@@ -124,13 +124,15 @@ Value jsonifya(
 ){
 
   Value agrows(kArrayType);
+  char titer[AcTiter::string_buffer_size];
   for(SizeType ag=0; ag<titertable.nags(); ag++){
     Value srtiters(kObjectType);
     for(SizeType sr=0; sr<titertable.nsr(); sr++){
       if(titertable.titer_measured(ag, sr)){
+        SizeType length = titertable.get_titer(ag, sr).format(titer);
         srtiters.AddMember(
           jsonifya( std::to_string(sr), allocator ),
-          jsonifya(titertable.get_titer_string(ag, sr), allocator),
+          Value(titer, length, allocator),
           allocator
         );
       }